@@ -0,0 +1,391 @@
+// Throughput of the render-to-video path, one stage at a time.
+//
+// Every mode adds one stage to the previous one: render, convert to I420,
+// read back, then hand the frames to a null, file or ffmpeg sink. Each mode is
+// swept over resolutions and readback depths and the results are written as
+// JSON so that two builds can be diffed.
+
+#include "engine.h"
+#include "mesh.h"
+#include "readback.h"
+#include "rendertarget.h"
+#include "sink.h"
+#include "yuv.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	enum class mode {
+		render,
+		convert,
+		readback,
+		sink_null,
+		sink_file,
+		sink_ffmpeg,
+	};
+
+	const char* mode_names[] = { "render", "convert", "readback", "sink-null", "sink-file", "sink-ffmpeg" };
+
+	struct resolution {
+		int width;
+		int height;
+	};
+
+	struct config {
+		int frames = 120;
+		int warmup = 30;
+		int objects = 1;
+		std::string mesh;
+		float lod_pixels = 1.0f;
+		std::vector<mode> modes = { mode::render, mode::convert, mode::readback,
+			mode::sink_null, mode::sink_file, mode::sink_ffmpeg };
+		std::vector<resolution> resolutions = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+		std::vector<int> depths = { 1, 2, 3, 4 };
+		std::string output = "benchmark.json";
+		std::string codec = "libx264";
+	};
+
+	struct result {
+		mode stage;
+		resolution size;
+		int depth;
+		double mean_ms;
+		double p50_ms;
+		double p99_ms;
+		double fps;
+		double readback_mb_s;
+		double drawn;
+		double triangles;
+		double full_triangles;
+	};
+
+	std::vector<std::string> split(const std::string& text) {
+		std::vector<std::string> parts;
+		std::stringstream ss(text);
+		std::string part;
+		while (std::getline(ss, part, ',')) {
+			parts.push_back(part);
+		}
+		return parts;
+	}
+
+	bool parse(int argc, char** argv, config& cfg) {
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[++i] : nullptr;
+			if (value == nullptr) {
+				return false;
+			}
+
+			if (std::strcmp(arg, "--frames") == 0) {
+				cfg.frames = std::max(1, std::atoi(value));
+			}
+			else if (std::strcmp(arg, "--warmup") == 0) {
+				cfg.warmup = std::max(0, std::atoi(value));
+			}
+			else if (std::strcmp(arg, "--objects") == 0) {
+				cfg.objects = std::max(1, std::atoi(value));
+			}
+			else if (std::strcmp(arg, "--mesh") == 0) {
+				cfg.mesh = value;
+			}
+			else if (std::strcmp(arg, "--lod-pixels") == 0) {
+				cfg.lod_pixels = std::max(0.0f, static_cast<float>(std::atof(value)));
+			}
+			else if (std::strcmp(arg, "--output") == 0) {
+				cfg.output = value;
+			}
+			else if (std::strcmp(arg, "--codec") == 0) {
+				cfg.codec = value;
+			}
+			else if (std::strcmp(arg, "--modes") == 0) {
+				cfg.modes.clear();
+				for (const auto& name : split(value)) {
+					auto it = std::find(std::begin(mode_names), std::end(mode_names), name);
+					if (it == std::end(mode_names)) {
+						std::cerr << "Unknown mode: " << name << std::endl;
+						return false;
+					}
+					cfg.modes.push_back(static_cast<mode>(it - std::begin(mode_names)));
+				}
+			}
+			else if (std::strcmp(arg, "--resolutions") == 0) {
+				cfg.resolutions.clear();
+				for (const auto& size : split(value)) {
+					resolution res{};
+					if (std::sscanf(size.c_str(), "%dx%d", &res.width, &res.height) != 2
+						|| res.width <= 0 || res.height <= 0 || res.width % 2 != 0 || res.height % 2 != 0) {
+						std::cerr << "Invalid resolution: " << size << std::endl;
+						return false;
+					}
+					cfg.resolutions.push_back(res);
+				}
+			}
+			else if (std::strcmp(arg, "--depths") == 0) {
+				cfg.depths.clear();
+				for (const auto& depth : split(value)) {
+					cfg.depths.push_back(std::clamp(std::atoi(depth.c_str()), 1, 8));
+				}
+			}
+			else {
+				std::cerr << "Unknown argument: " << arg << std::endl;
+				return false;
+			}
+		}
+
+		return !cfg.modes.empty() && !cfg.resolutions.empty() && !cfg.depths.empty();
+	}
+
+	double percentile(std::vector<double> sorted, double p) {
+		std::sort(sorted.begin(), sorted.end());
+		const size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+		return sorted[index];
+	}
+
+	bool run(const config& cfg, mode m, resolution size, int depth, result& out) {
+		const int width = size.width;
+		const int height = size.height;
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+
+		RenderTarget target;
+		yuv rgb_to_yuv;
+		if (!target.init(width, height) || !rgb_to_yuv.init(width, height)) {
+			return false;
+		}
+
+		std::unique_ptr<sink> output;
+		const std::string file = (std::filesystem::temp_directory_path() / "benchmark").string();
+		switch (m) {
+		case mode::sink_null:
+			output = open_sink("null", width, height, 30, cfg.codec);
+			break;
+		case mode::sink_file:
+			output = open_sink(file + ".yuv", width, height, 30, cfg.codec);
+			break;
+		case mode::sink_ffmpeg:
+			output = open_sink(file + ".mkv", width, height, 30, cfg.codec);
+			break;
+		default:
+			break;
+		}
+		if (m >= mode::sink_null && !output) {
+			return false;
+		}
+
+		readback frames;
+		if (m >= mode::readback && !frames.init(width, height, depth,
+			[&](const GLubyte* data, size_t bytes) {
+				if (output) {
+					output->write(data, bytes);
+				}
+			})) {
+			return false;
+		}
+
+		mesh shape;
+		if (!cfg.mesh.empty() && !shape.init(cfg.mesh)) {
+			return false;
+		}
+
+		engine scene(projection, cfg.objects, cfg.mesh.empty() ? nullptr : &shape);
+		scene.set_lod(cfg.lod_pixels, height);
+		double drawn = 0;
+		double triangles = 0;
+		double full_triangles = 0;
+		std::vector<double> frame_ms;
+		frame_ms.reserve(cfg.frames);
+
+		using clock = std::chrono::high_resolution_clock;
+		clock::time_point measured_from;
+
+		for (int frame = 0; frame < cfg.warmup + cfg.frames; frame++) {
+			if (frame == cfg.warmup) {
+				measured_from = clock::now();
+			}
+			const auto start = clock::now();
+
+			scene.update(static_cast<double>(frame) / 30);
+			target.Begin();
+			scene.render();
+			target.End();
+			if (frame >= cfg.warmup) {
+				drawn += scene.get_cull_stats().drawn;
+				triangles += static_cast<double>(scene.get_lod_stats().triangles);
+				full_triangles += static_cast<double>(scene.get_lod_stats().full_triangles);
+			}
+
+			if (m >= mode::convert) {
+				rgb_to_yuv.Begin();
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				rgb_to_yuv.ConvertToYUV(target.get_texture());
+				rgb_to_yuv.End();
+			}
+
+			if (m >= mode::readback) {
+				frames.push(rgb_to_yuv);
+			}
+			else {
+				// Nothing else waits for the GPU in these modes.
+				glFinish();
+			}
+
+			if (frame >= cfg.warmup) {
+				frame_ms.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+			}
+		}
+
+		if (m >= mode::readback) {
+			frames.drain();
+		}
+		const double seconds = std::chrono::duration<double>(clock::now() - measured_from).count();
+
+		double sum = 0;
+		for (double ms : frame_ms) {
+			sum += ms;
+		}
+
+		const double frame_bytes = width * height * 3 / 2.0;
+		out.stage = m;
+		out.size = size;
+		out.depth = m >= mode::readback ? depth : 0;
+		out.mean_ms = sum / frame_ms.size();
+		out.p50_ms = percentile(frame_ms, 0.5);
+		out.p99_ms = percentile(frame_ms, 0.99);
+		out.fps = cfg.frames / seconds;
+		out.readback_mb_s = m >= mode::readback ? frame_bytes * cfg.frames / seconds / (1024 * 1024) : 0;
+		out.drawn = drawn / cfg.frames;
+		out.triangles = triangles / cfg.frames;
+		out.full_triangles = full_triangles / cfg.frames;
+
+		output.reset();
+		for (const char* ext : { ".yuv", ".mkv" }) {
+			std::error_code ec;
+			std::filesystem::remove(file + ext, ec);
+		}
+		return true;
+	}
+
+	// Quoted JSON string: backslashes, quotes and control characters are escaped.
+	std::string json_string(const std::string& text) {
+		std::string quoted = "\"";
+		for (const char c : text) {
+			if (c == '"' || c == '\\') {
+				quoted += '\\';
+				quoted += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				const char* hex = "0123456789abcdef";
+				quoted += "\\u00";
+				quoted += hex[c >> 4];
+				quoted += hex[c & 15];
+			}
+			else {
+				quoted += c;
+			}
+		}
+		quoted += '"';
+		return quoted;
+	}
+
+	void write_json(std::ostream& out, const config& cfg, const std::vector<result>& results) {
+		out << "{\n"
+			<< "  \"renderer\": " << json_string(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << ",\n"
+			<< "  \"warmup\": " << cfg.warmup << ",\n"
+			<< "  \"frames\": " << cfg.frames << ",\n"
+			<< "  \"objects\": " << cfg.objects << ",\n"
+			<< "  \"mesh\": " << json_string(cfg.mesh.empty() ? "cube" : cfg.mesh) << ",\n"
+			<< "  \"lod_pixels\": " << cfg.lod_pixels << ",\n"
+			<< "  \"results\": [";
+
+		for (size_t i = 0; i < results.size(); i++) {
+			const auto& r = results[i];
+			out << (i == 0 ? "\n" : ",\n")
+				<< "    { \"mode\": \"" << mode_names[static_cast<int>(r.stage)] << "\""
+				<< ", \"width\": " << r.size.width
+				<< ", \"height\": " << r.size.height
+				<< ", \"frames_in_flight\": " << r.depth
+				<< ", \"mean_ms\": " << r.mean_ms
+				<< ", \"p50_ms\": " << r.p50_ms
+				<< ", \"p99_ms\": " << r.p99_ms
+				<< ", \"fps\": " << r.fps
+				<< ", \"readback_mb_s\": " << r.readback_mb_s
+				<< ", \"drawn\": " << r.drawn
+				<< ", \"triangles\": " << r.triangles
+				<< ", \"full_triangles\": " << r.full_triangles
+				<< " }";
+		}
+
+		out << "\n  ]\n}" << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	config cfg;
+	if (!parse(argc, argv, cfg)) {
+		std::cerr << "usage: " << argv[0] << " [--frames n] [--warmup n] [--objects n] [--output file.json (default benchmark.json)]" << std::endl
+			<< "  [--mesh file.rmesh] [--lod-pixels n (default 1, 0 draws full detail)]" << std::endl
+			<< "  [--modes render,convert,readback,sink-null,sink-file,sink-ffmpeg]" << std::endl
+			<< "  [--resolutions 640x360,1280x720] [--depths 1,2,3,4] [--codec name]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (!glfwInit()) {
+		return EXIT_FAILURE;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Benchmark", nullptr, nullptr);
+	if (!window) {
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+
+	glfwMakeContextCurrent(window);
+	// No vsync, the window is never presented anyway.
+	glfwSwapInterval(0);
+
+	if (glewInit() != GLEW_OK) {
+		std::cerr << "GLEW init failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::vector<result> results;
+	for (auto m : cfg.modes) {
+		for (const auto& size : cfg.resolutions) {
+			// The readback depth only matters once there is a readback.
+			const std::vector<int> depths = m >= mode::readback ? cfg.depths : std::vector<int>{ 1 };
+			for (int depth : depths) {
+				result r{};
+				if (!run(cfg, m, size, depth, r)) {
+					std::cerr << "Benchmark " << mode_names[static_cast<int>(m)] << " "
+						<< size.width << "x" << size.height << " failed" << std::endl;
+					return EXIT_FAILURE;
+				}
+				std::cerr << mode_names[static_cast<int>(m)] << " " << size.width << "x" << size.height
+					<< " depth " << r.depth << ": " << r.mean_ms << " ms" << std::endl;
+				results.push_back(r);
+			}
+		}
+	}
+
+	std::ofstream file(cfg.output);
+	write_json(file, cfg, results);
+	std::cout << "Results written to " << cfg.output << std::endl;
+
+	glfwTerminate();
+	return 0;
+}
@@ -1,9 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include "font.h"
 
 #define NUM_GLYPHS 128
 
@@ -19,16 +19,14 @@ int main(int argc, char** argv) {
 		return 1;
 	}
 
-	FT_Library ft;
-	FT_Face    face;
-
-	FT_Init_FreeType(&ft);
-	FT_New_Face(ft, argv[1], 0, &face);
-	FT_Set_Char_Size(face, 0, atoi(argv[2]) << 6, 96, 96);
+	font face;
+	if (!face.init(argv[1], atoi(argv[2]))) {
+		return 1;
+	}
 
 	// quick and dirty max texture size estimate
 
-	int max_dim = (1 + (face->size->metrics.height >> 6)) * ceilf(sqrtf(NUM_GLYPHS));
+	int max_dim = face.line_height() * ceilf(sqrtf(NUM_GLYPHS));
 	int tex_width = 1;
 	while (tex_width < max_dim) tex_width <<= 1;
 	int tex_height = tex_width;
@@ -39,12 +37,15 @@ int main(int argc, char** argv) {
 	int pen_x = 0, pen_y = 0;
 
 	for (int i = 0; i < NUM_GLYPHS; ++i) {
-		FT_Load_Char(face, i, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_TARGET_LIGHT);
-		FT_Bitmap* bmp = &face->glyph->bitmap;
+		font::bitmap glyph;
+		if (!face.rasterize(i, glyph)) {
+			continue;
+		}
+		const font::bitmap* bmp = &glyph;
 
 		if (pen_x + bmp->width >= tex_width) {
 			pen_x = 0;
-			pen_y += ((face->size->metrics.height >> 6) + 1);
+			pen_y += face.line_height();
 		}
 
 		for (int row = 0; row < bmp->rows; ++row) {
@@ -62,15 +63,13 @@ int main(int argc, char** argv) {
 		info[i].x1 = pen_x + bmp->width;
 		info[i].y1 = pen_y + bmp->rows;
 
-		info[i].x_off = face->glyph->bitmap_left;
-		info[i].y_off = face->glyph->bitmap_top;
-		info[i].advance = face->glyph->advance.x >> 6;
+		info[i].x_off = bmp->left;
+		info[i].y_off = bmp->top;
+		info[i].advance = bmp->advance;
 
 		pen_x += bmp->width + 1;
 	}
 
-	FT_Done_FreeType(ft);
-
 	// write png
 
 	char* png_data = (char*)calloc(tex_width * tex_height * 4, 1);
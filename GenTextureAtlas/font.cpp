@@ -0,0 +1,66 @@
+#include "font.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <iostream>
+
+font::~font()
+{
+	Free();
+}
+
+bool font::init(const std::string& path, int size)
+{
+	if (library != nullptr) {
+		return false;
+	}
+
+	if (FT_Init_FreeType(&library) != 0) {
+		std::cerr << "Cannot initialize FreeType" << std::endl;
+		return false;
+	}
+	if (FT_New_Face(library, path.c_str(), 0, &face) != 0) {
+		std::cerr << "Cannot load font " << path << std::endl;
+		Free();
+		return false;
+	}
+	if (FT_Set_Char_Size(face, 0, size << 6, 96, 96) != 0) {
+		std::cerr << "Cannot use " << path << " at size " << size << std::endl;
+		Free();
+		return false;
+	}
+
+	line = static_cast<int>(face->size->metrics.height >> 6) + 1;
+	ascent = static_cast<int>(face->size->metrics.ascender >> 6);
+	return true;
+}
+
+bool font::rasterize(uint32_t codepoint, bitmap& out)
+{
+	if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_TARGET_LIGHT) != 0) {
+		return false;
+	}
+
+	const FT_GlyphSlot slot = face->glyph;
+	out.width = static_cast<int>(slot->bitmap.width);
+	out.rows = static_cast<int>(slot->bitmap.rows);
+	out.pitch = slot->bitmap.pitch;
+	out.buffer = slot->bitmap.buffer;
+	out.left = slot->bitmap_left;
+	out.top = slot->bitmap_top;
+	out.advance = static_cast<int>(slot->advance.x >> 6);
+	return true;
+}
+
+void font::Free()
+{
+	if (face != nullptr) {
+		FT_Done_Face(face);
+	}
+	if (library != nullptr) {
+		FT_Done_FreeType(library);
+	}
+	face = nullptr;
+	library = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+// A FreeType face at one size, rasterizing single glyphs to 8 bit coverage.
+
+class font
+{
+public:
+	struct bitmap {
+		int width = 0;
+		int rows = 0;
+		int pitch = 0;
+		const unsigned char* buffer = nullptr;
+		int left = 0;		// bearing from the pen position
+		int top = 0;		// bearing above the baseline
+		int advance = 0;
+	};
+
+	virtual ~font();
+
+	// Size in points at 96 dpi.
+	[[nodiscard]] bool init(const std::string& path, int size);
+
+	// The buffer is only valid until the next call.
+	[[nodiscard]] bool rasterize(uint32_t codepoint, bitmap& out);
+
+	// Distance between baselines, every glyph fits in it.
+	[[nodiscard]] int line_height() const { return line; }
+	[[nodiscard]] int ascender() const { return ascent; }
+
+private:
+	void Free();
+
+private:
+	FT_LibraryRec_* library = nullptr;
+	FT_FaceRec_* face = nullptr;
+	int line = 0;
+	int ascent = 0;
+};
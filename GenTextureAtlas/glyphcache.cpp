@@ -0,0 +1,178 @@
+#include "glyphcache.h"
+#include "glprofile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+glyph_cache::~glyph_cache()
+{
+	Free();
+}
+
+bool glyph_cache::init(font& face, int size)
+{
+	if (tex > 0) {
+		return false;
+	}
+
+	this->face = &face;
+	this->size = size;
+	line = face.line_height();
+	if (line <= 0 || line > size) {
+		std::cerr << "Glyph cache: lines of " << line << " pixels do not fit an atlas of " << size << std::endl;
+		return false;
+	}
+
+	pixels.assign(static_cast<size_t>(size) * size, 0);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &tex);
+	glTextureStorage2D(tex, 1, GL_R8, size, size);
+	glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Starts out empty, the gaps between glyphs have to stay clear for filtering.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(tex, 0, 0, 0, size, size, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+	return true;
+}
+
+bool glyph_cache::get(uint32_t codepoint, glyph& out)
+{
+	auto it = glyphs.find(codepoint);
+	if (it != glyphs.end()) {
+		counters.hits++;
+		shelves[it->second.shelf].last_used = frame;
+		out = it->second.metrics;
+		return true;
+	}
+
+	counters.misses++;
+	font::bitmap bmp;
+	if (!face->rasterize(codepoint, bmp) || bmp.rows > line) {
+		return false;
+	}
+
+	// One column of padding keeps neighbours out of the filtered edges.
+	const int index = find_shelf(bmp.width + 1);
+	if (index < 0) {
+		return false;
+	}
+
+	auto& s = shelves[index];
+	const int x = s.pen;
+	for (int row = 0; row < bmp.rows; row++) {
+		std::memcpy(&pixels[static_cast<size_t>(s.y + row) * size + x], bmp.buffer + row * bmp.pitch, bmp.width);
+	}
+	s.dirty_begin = s.dirty_end > s.dirty_begin ? std::min(s.dirty_begin, x) : x;
+	s.dirty_end = std::max(s.dirty_end, x + bmp.width);
+	s.pen += bmp.width + 1;
+	s.last_used = frame;
+	s.codepoints.push_back(codepoint);
+
+	entry e;
+	e.shelf = index;
+	e.metrics.u0 = static_cast<float>(x) / size;
+	e.metrics.v0 = static_cast<float>(s.y) / size;
+	e.metrics.u1 = static_cast<float>(x + bmp.width) / size;
+	e.metrics.v1 = static_cast<float>(s.y + bmp.rows) / size;
+	e.metrics.width = bmp.width;
+	e.metrics.height = bmp.rows;
+	e.metrics.left = bmp.left;
+	e.metrics.top = bmp.top;
+	e.metrics.advance = bmp.advance;
+	glyphs.emplace(codepoint, e);
+
+	out = e.metrics;
+	return true;
+}
+
+int glyph_cache::find_shelf(int width)
+{
+	if (width > size) {
+		return -1;
+	}
+
+	for (size_t i = 0; i < shelves.size(); i++) {
+		if (shelves[i].pen + width <= size) {
+			return static_cast<int>(i);
+		}
+	}
+
+	const int next_y = static_cast<int>(shelves.size()) * line;
+	if (next_y + line <= size) {
+		shelf s;
+		s.y = next_y;
+		shelves.push_back(s);
+		return static_cast<int>(shelves.size()) - 1;
+	}
+
+	int oldest = -1;
+	for (size_t i = 0; i < shelves.size(); i++) {
+		if (shelves[i].last_used < frame && (oldest < 0 || shelves[i].last_used < shelves[oldest].last_used)) {
+			oldest = static_cast<int>(i);
+		}
+	}
+	if (oldest < 0) {
+		std::cerr << "Glyph cache: the text of one frame does not fit an atlas of " << size << std::endl;
+		return -1;
+	}
+
+	evict(oldest);
+	return oldest;
+}
+
+void glyph_cache::evict(int index)
+{
+	auto& s = shelves[index];
+	for (auto codepoint : s.codepoints) {
+		glyphs.erase(codepoint);
+	}
+	s.codepoints.clear();
+
+	// Cleared on the GPU as well, the new glyphs rely on empty padding.
+	for (int row = 0; row < line; row++) {
+		std::memset(&pixels[static_cast<size_t>(s.y + row) * size], 0, s.pen);
+	}
+	s.dirty_begin = 0;
+	s.dirty_end = std::max(s.dirty_end, s.pen);
+	s.pen = 0;
+	counters.evictions++;
+}
+
+void glyph_cache::flush()
+{
+	bool bound = false;
+	for (auto& s : shelves) {
+		if (s.dirty_end <= s.dirty_begin) {
+			continue;
+		}
+		if (!bound) {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+			bound = true;
+		}
+
+		const int width = s.dirty_end - s.dirty_begin;
+		glTextureSubImage2D(tex, 0, s.dirty_begin, s.y, width, line, GL_RED, GL_UNSIGNED_BYTE,
+			&pixels[static_cast<size_t>(s.y) * size + s.dirty_begin]);
+		counters.uploads++;
+		counters.bytes_uploaded += static_cast<int64_t>(width) * line;
+		s.dirty_begin = s.dirty_end = 0;
+	}
+	if (bound) {
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+	frame++;
+}
+
+void glyph_cache::Free()
+{
+	glDeleteTextures(1, &tex);
+	tex = 0;
+	pixels.clear();
+	shelves.clear();
+	glyphs.clear();
+}
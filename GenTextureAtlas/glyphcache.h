@@ -0,0 +1,82 @@
+#pragma once
+#include "font.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Glyphs rasterized on first use into a fixed size R8 atlas texture, so text with
+// any codepoints can be drawn while the atlas stays bounded. Glyphs are packed on
+// shelves one line high, the way GenTextureAtlas packs its atlas. A CPU copy of the
+// atlas collects new glyphs and flush() uploads only the changed span of each shelf.
+// When no shelf has room the least recently used one is emptied as a whole; a
+// shelf used in the current frame is never evicted.
+
+class glyph_cache
+{
+public:
+	struct glyph {
+		float u0 = 0, v0 = 0, u1 = 0, v1 = 0;	// v0 is the top row
+		int width = 0;
+		int height = 0;
+		int left = 0;
+		int top = 0;
+		int advance = 0;
+	};
+
+	struct stats {
+		int64_t hits = 0;
+		int64_t misses = 0;
+		int64_t evictions = 0;		// shelves emptied
+		int64_t uploads = 0;		// glTextureSubImage2D calls
+		int64_t bytes_uploaded = 0;
+	};
+
+	virtual ~glyph_cache();
+
+	// An atlas of size x size pixels for glyphs of face, which must outlive the cache.
+	[[nodiscard]] bool init(font& face, int size);
+
+	// The glyph of a codepoint, rasterized and packed if it is not in the atlas yet.
+	// False if the font has no such glyph or the current frame already fills the atlas.
+	[[nodiscard]] bool get(uint32_t codepoint, glyph& out);
+
+	// Uploads what changed since the last call and starts the next frame.
+	void flush();
+
+	[[nodiscard]] GLuint get_texture() const { return tex; }
+	[[nodiscard]] const stats& get_stats() const { return counters; }
+
+private:
+	struct shelf {
+		int y = 0;
+		int pen = 0;				// next free column
+		int dirty_begin = 0;
+		int dirty_end = 0;
+		uint64_t last_used = 0;
+		std::vector<uint32_t> codepoints;
+	};
+
+	struct entry {
+		glyph metrics;
+		int shelf = 0;
+	};
+
+	// A shelf with room for width pixels, evicting the least recently used one if needed.
+	[[nodiscard]] int find_shelf(int width);
+	void evict(int index);
+	void Free();
+
+private:
+	font* face = nullptr;
+	int size = 0;
+	int line = 0;
+	GLuint tex = 0;
+	std::vector<unsigned char> pixels;
+	std::vector<shelf> shelves;
+	std::unordered_map<uint32_t, entry> glyphs;
+	uint64_t frame = 1;
+	stats counters;
+};
@@ -0,0 +1,183 @@
+#include "text.h"
+#include "glprofile.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+namespace {
+	const char* vert_src = R"(
+		#version 330 core
+		layout(location = 0) in vec2 pos;
+		layout(location = 1) in vec2 tex;
+
+		uniform vec2 size;
+		out vec2 uv;
+
+		void main() {
+			uv = tex;
+			gl_Position = vec4(pos / size * 2 - 1, 0, 1);
+		}
+	)";
+
+	const char* frag_src = R"(
+		#version 330 core
+		in vec2 uv;
+		out vec4 color;
+
+		uniform sampler2D atlas;
+
+		void main() {
+			float coverage = texture(atlas, uv).r;
+			color = vec4(coverage, coverage, coverage, coverage);
+		}
+	)";
+
+	GLuint compile(GLenum type, const char* src) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &src, nullptr);
+		glCompileShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			GLchar log[256]{};
+			glGetShaderInfoLog(shader, sizeof(log) - 1, nullptr, log);
+			std::cerr << "Text shader: " << log << std::endl;
+		}
+		return shader;
+	}
+
+	// Next codepoint of a UTF-8 string, U+FFFD for malformed sequences.
+	uint32_t decode(const std::string& s, size_t& i) {
+		const auto lead = static_cast<unsigned char>(s[i++]);
+		if (lead < 0x80) {
+			return lead;
+		}
+
+		const int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+		if (extra < 0) {
+			return 0xFFFD;
+		}
+		uint32_t codepoint = lead & (0x3F >> extra);
+		for (int k = 0; k < extra; k++) {
+			if (i >= s.size() || (static_cast<unsigned char>(s[i]) & 0xC0) != 0x80) {
+				return 0xFFFD;
+			}
+			codepoint = codepoint << 6 | (static_cast<unsigned char>(s[i++]) & 0x3F);
+		}
+		return codepoint;
+	}
+}
+
+text::~text()
+{
+	Free();
+}
+
+bool text::init(glyph_cache& cache, int width, int height)
+{
+	if (program_id > 0) {
+		return false;
+	}
+
+	this->cache = &cache;
+	this->width = width;
+	this->height = height;
+
+	const GLuint vert = compile(GL_VERTEX_SHADER, vert_src);
+	const GLuint frag = compile(GL_FRAGMENT_SHADER, frag_src);
+	program_id = glCreateProgram();
+	glAttachShader(program_id, vert);
+	glAttachShader(program_id, frag);
+	glLinkProgram(program_id);
+	glDeleteShader(vert);
+	glDeleteShader(frag);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE) {
+		std::cerr << "Cannot link the text shader" << std::endl;
+		return false;
+	}
+	size_location = glGetUniformLocation(program_id, "size");
+
+	glCreateBuffers(1, &vbo);
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(vertex));
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, x));
+	glVertexArrayAttribBinding(vao, 0, 0);
+	glEnableVertexArrayAttrib(vao, 1);
+	glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(vertex, u));
+	glVertexArrayAttribBinding(vao, 1, 0);
+	return true;
+}
+
+void text::add(const std::string& utf8, int x, int y)
+{
+	int pen = x;
+	for (size_t i = 0; i < utf8.size();) {
+		glyph_cache::glyph g;
+		if (!cache->get(decode(utf8, i), g)) {
+			continue;
+		}
+
+		const float x0 = static_cast<float>(pen + g.left);
+		const float y0 = static_cast<float>(y - g.top);
+		const float x1 = x0 + g.width;
+		const float y1 = y0 + g.height;
+		quads.insert(quads.end(), {
+			{ x0, y0, g.u0, g.v0 }, { x1, y0, g.u1, g.v0 }, { x0, y1, g.u0, g.v1 },
+			{ x0, y1, g.u0, g.v1 }, { x1, y0, g.u1, g.v0 }, { x1, y1, g.u1, g.v1 },
+		});
+		pen += g.advance;
+	}
+}
+
+void text::draw()
+{
+	cache->flush();
+	if (quads.empty()) {
+		return;
+	}
+
+	// Orphan the buffer instead of waiting for the previous frame's draw.
+	const auto bytes = static_cast<GLsizeiptr>(quads.size() * sizeof(vertex));
+	vbo_size = std::max(vbo_size, bytes);
+	glNamedBufferData(vbo, vbo_size, nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(vbo, 0, bytes, quads.data());
+
+	const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(program_id);
+	glUniform2f(size_location, static_cast<float>(width), static_cast<float>(height));
+	glBindTextureUnit(0, cache->get_texture());
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(quads.size()));
+	glBindVertexArray(0);
+	glBindTextureUnit(0, 0);
+	glUseProgram(0);
+
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	if (depth_test) {
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	quads.clear();
+}
+
+void text::Free()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &vbo);
+	glDeleteProgram(program_id);
+	vao = 0;
+	vbo = 0;
+	program_id = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "glyphcache.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// Lines of UTF-8 text drawn from a glyph_cache over the bound framebuffer, all
+// lines queued in a frame as one batch of quads.
+
+class text
+{
+public:
+	virtual ~text();
+
+	// Coordinates are pixels of a width x height framebuffer, from its top left.
+	[[nodiscard]] bool init(glyph_cache& cache, int width, int height);
+
+	// Queues a line whose baseline starts at (x, y).
+	void add(const std::string& utf8, int x, int y);
+	// Uploads new glyphs and draws the queued lines with alpha blending.
+	void draw();
+
+private:
+	void Free();
+
+	struct vertex {
+		float x, y, u, v;
+	};
+
+private:
+	glyph_cache* cache = nullptr;
+	int width = 0;
+	int height = 0;
+	GLuint program_id = 0;
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	GLsizeiptr vbo_size = 0;
+	GLint size_location = -1;
+	std::vector<vertex> quads;
+};
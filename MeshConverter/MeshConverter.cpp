@@ -0,0 +1,275 @@
+// Converts a Wavefront OBJ mesh to the binary format of meshfile.h, with a chain
+// of simplified levels of detail.
+// https://paulbourke.net/dataformats/obj/
+
+#include "meshfile.h"
+#include "simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	struct float3 {
+		float x, y, z;
+	};
+
+	struct obj {
+		std::vector<float3> positions;
+		std::vector<float3> colors;		// optional "v x y z r g b" extension
+		std::vector<uint32_t> indices;	// triangles into positions
+	};
+
+	// Face corners are "v", "v/vt", "v//vn" or "v/vt/vn", negative indices count from the end.
+	bool parse_corner(const std::string& token, size_t vertex_count, uint32_t& index) {
+		char* end = nullptr;
+		const long value = std::strtol(token.c_str(), &end, 10);
+		if (end == token.c_str() || (*end != '\0' && *end != '/')) {
+			return false;
+		}
+
+		const long resolved = value < 0 ? static_cast<long>(vertex_count) + value : value - 1;
+		if (resolved < 0 || resolved >= static_cast<long>(vertex_count)) {
+			return false;
+		}
+		index = static_cast<uint32_t>(resolved);
+		return true;
+	}
+
+	bool load_obj(const char* path, obj& mesh) {
+		std::ifstream in(path);
+		if (!in) {
+			std::cerr << "Cannot open " << path << std::endl;
+			return false;
+		}
+
+		std::string line;
+		std::vector<uint32_t> polygon;
+		for (int line_no = 1; std::getline(in, line); line_no++) {
+			std::istringstream fields(line);
+			std::string kind;
+			fields >> kind;
+
+			if (kind == "v") {
+				float3 p{}, c{ -1, -1, -1 };
+				if (!(fields >> p.x >> p.y >> p.z)) {
+					std::cerr << path << ":" << line_no << ": invalid vertex" << std::endl;
+					return false;
+				}
+				fields >> c.x >> c.y >> c.z;
+				mesh.positions.push_back(p);
+				mesh.colors.push_back(c);
+			}
+			else if (kind == "f") {
+				polygon.clear();
+				std::string token;
+				while (fields >> token) {
+					uint32_t index = 0;
+					if (!parse_corner(token, mesh.positions.size(), index)) {
+						std::cerr << path << ":" << line_no << ": invalid face corner " << token << std::endl;
+						return false;
+					}
+					polygon.push_back(index);
+				}
+
+				// Fan triangulation, faces are expected to be convex.
+				for (size_t i = 2; i < polygon.size(); i++) {
+					mesh.indices.push_back(polygon[0]);
+					mesh.indices.push_back(polygon[i - 1]);
+					mesh.indices.push_back(polygon[i]);
+				}
+			}
+		}
+
+		if (mesh.indices.empty()) {
+			std::cerr << path << " has no faces" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	uint16_t quantize(float value, float min, float max) {
+		const float t = max > min ? (value - min) / (max - min) : 0.0f;
+		return static_cast<uint16_t>(std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	uint8_t unorm8(float value) {
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+	}
+
+	uint64_t aligned(uint64_t offset) {
+		return (offset + meshfile::alignment - 1) / meshfile::alignment * meshfile::alignment;
+	}
+
+	void pad(std::ofstream& out, uint64_t& offset) {
+		static const char zeros[meshfile::alignment] = {};
+		out.write(zeros, static_cast<std::streamsize>(aligned(offset) - offset));
+		offset = aligned(offset);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool fit = false;
+	int max_lods = 4;
+	int arg = 1;
+	for (; arg < argc && std::strncmp(argv[arg], "--", 2) == 0; arg++) {
+		if (std::strcmp(argv[arg], "--fit") == 0) {
+			fit = true;
+		}
+		else if (std::strcmp(argv[arg], "--lods") == 0 && arg + 1 < argc) {
+			max_lods = std::clamp(std::atoi(argv[++arg]), 1, 16);
+		}
+		else {
+			break;
+		}
+	}
+
+	if (argc - arg != 2) {
+		std::cerr << "usage: " << argv[0] << " [--fit] [--lods <n>] <input.obj> <output.rmesh>" << std::endl
+			<< "  --fit       center the mesh and scale it into [-1, 1] like the built-in cube" << std::endl
+			<< "  --lods <n>  levels of detail including the full mesh, each with half the triangles (default 4)" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	obj source;
+	if (!load_obj(argv[arg], source)) {
+		return EXIT_FAILURE;
+	}
+
+	// Keep only referenced vertices, numbered in order of first use so that
+	// vertex fetches follow the index stream.
+	std::vector<uint32_t> remap(source.positions.size(), UINT32_MAX);
+	std::vector<uint32_t> order;
+	for (auto& index : source.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(order.size());
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+
+	float3 min{ INFINITY, INFINITY, INFINITY };
+	float3 max{ -INFINITY, -INFINITY, -INFINITY };
+	std::vector<float> positions;
+	positions.reserve(order.size() * 3);
+	for (uint32_t v : order) {
+		const auto& p = source.positions[v];
+		min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+		max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+		positions.insert(positions.end(), { p.x, p.y, p.z });
+	}
+
+	// Colors from the file if every vertex has one, otherwise from the position in the bounds.
+	const bool has_colors = std::all_of(order.begin(), order.end(),
+		[&](uint32_t v) { return source.colors[v].x >= 0; });
+
+	std::vector<meshfile::vertex> vertices(order.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		const auto& p = source.positions[order[i]];
+		auto& out = vertices[i];
+		out.position[0] = quantize(p.x, min.x, max.x);
+		out.position[1] = quantize(p.y, min.y, max.y);
+		out.position[2] = quantize(p.z, min.z, max.z);
+		out.position[3] = 0;
+
+		const float3 c = has_colors ? source.colors[order[i]]
+			: float3{ out.position[0] / 65535.0f, out.position[1] / 65535.0f, out.position[2] / 65535.0f };
+		out.color[0] = unorm8(c.x);
+		out.color[1] = unorm8(c.y);
+		out.color[2] = unorm8(c.z);
+		out.color[3] = 255;
+	}
+
+	// Fitting only changes the bounds the positions are decoded into.
+	float scale = 1.0f;
+	if (fit) {
+		const float3 center{ (min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2 };
+		const float half = std::max({ max.x - min.x, max.y - min.y, max.z - min.z }) / 2;
+		scale = half > 0 ? 1.0f / half : 1.0f;
+		min = { (min.x - center.x) * scale, (min.y - center.y) * scale, (min.z - center.z) * scale };
+		max = { (max.x - center.x) * scale, (max.y - center.y) * scale, (max.z - center.z) * scale };
+	}
+
+	// Each level halves the triangles of the previous one. The chain ends early
+	// when simplification stalls, e.g. on a mesh that is already minimal.
+	std::vector<meshfile::lod> lods;
+	std::vector<uint32_t> indices = source.indices;
+	lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f, 0 });
+
+	simplifier chain(positions, source.indices);
+	size_t triangles = source.indices.size() / 3;
+	while (static_cast<int>(lods.size()) < max_lods) {
+		const size_t left = chain.simplify(triangles / 2);
+		if (left > triangles * 9 / 10 || left == 0) {
+			break;
+		}
+		triangles = left;
+
+		const auto level = chain.indices();
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level.size()),
+			chain.error() * scale, 0 });
+		indices.insert(indices.end(), level.begin(), level.end());
+	}
+
+	meshfile::header header{};
+	std::memcpy(header.magic, meshfile::magic, sizeof(header.magic));
+	header.version = meshfile::version;
+	header.vertex_count = static_cast<uint32_t>(vertices.size());
+	header.index_count = static_cast<uint32_t>(indices.size());
+	header.index_size = vertices.size() <= 65536 ? 2 : 4;
+	header.lod_count = static_cast<uint32_t>(lods.size());
+	header.bounds_min[0] = min.x;
+	header.bounds_min[1] = min.y;
+	header.bounds_min[2] = min.z;
+	header.bounds_max[0] = max.x;
+	header.bounds_max[1] = max.y;
+	header.bounds_max[2] = max.z;
+
+	header.vertex_offset = aligned(sizeof(header) + lods.size() * sizeof(meshfile::lod));
+	header.index_offset = aligned(header.vertex_offset + vertices.size() * sizeof(meshfile::vertex));
+
+	std::ofstream out(argv[arg + 1], std::ios::binary);
+	if (!out) {
+		std::cerr << "Cannot create " << argv[arg + 1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	uint64_t offset = sizeof(header) + lods.size() * sizeof(meshfile::lod);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(lods.data()),
+		static_cast<std::streamsize>(lods.size() * sizeof(meshfile::lod)));
+	pad(out, offset);
+	out.write(reinterpret_cast<const char*>(vertices.data()),
+		static_cast<std::streamsize>(vertices.size() * sizeof(meshfile::vertex)));
+	offset += vertices.size() * sizeof(meshfile::vertex);
+	pad(out, offset);
+
+	if (header.index_size == 2) {
+		std::vector<uint16_t> narrow(indices.begin(), indices.end());
+		out.write(reinterpret_cast<const char*>(narrow.data()),
+			static_cast<std::streamsize>(narrow.size() * sizeof(uint16_t)));
+	}
+	else {
+		out.write(reinterpret_cast<const char*>(indices.data()),
+			static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+	}
+
+	if (!out) {
+		std::cerr << "Cannot write " << argv[arg + 1] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << argv[arg + 1] << ": " << vertices.size() << " vertices" << std::endl;
+	for (size_t i = 0; i < lods.size(); i++) {
+		std::cout << "  LOD " << i << ": " << lods[i].index_count / 3 << " triangles, error " << lods[i].error << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,264 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+	// Boundary edges get a plane perpendicular to their face with this much
+	// weight relative to face area, so open borders keep their outline.
+	constexpr double boundary_weight = 10.0;
+
+	void cross(const double* a, const double* b, double* out) {
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	double dot(const double* a, const double* b) {
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Unnormalized normal, its length is twice the area.
+	void face_normal(const double* p0, const double* p1, const double* p2, double* out) {
+		const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		cross(e1, e2, out);
+	}
+}
+
+void simplifier::quadric::add_plane(double nx, double ny, double nz, double d, double weight)
+{
+	const double p[4] = { nx, ny, nz, d };
+	int k = 0;
+	for (int i = 0; i < 4; i++) {
+		for (int j = i; j < 4; j++) {
+			a[k++] += weight * p[i] * p[j];
+		}
+	}
+}
+
+simplifier::quadric& simplifier::quadric::operator+=(const quadric& q)
+{
+	for (int i = 0; i < 10; i++) {
+		a[i] += q.a[i];
+	}
+	area += q.area;
+	return *this;
+}
+
+double simplifier::quadric::evaluate(const double* p) const
+{
+	const double v[4] = { p[0], p[1], p[2], 1 };
+	double sum = 0;
+	int k = 0;
+	for (int i = 0; i < 4; i++) {
+		for (int j = i; j < 4; j++) {
+			sum += (i == j ? 1 : 2) * a[k++] * v[i] * v[j];
+		}
+	}
+	return std::max(sum, 0.0);
+}
+
+simplifier::simplifier(const std::vector<float>& positions, const std::vector<uint32_t>& indices)
+	: position(positions.begin(), positions.end())
+	, triangles(indices)
+	, triangle_alive(indices.size() / 3, 1)
+	, vertex_triangles(positions.size() / 3)
+	, quadrics(positions.size() / 3)
+	, version(positions.size() / 3, 0)
+	, alive(indices.size() / 3)
+{
+	// Triangles per undirected edge, keyed by both vertex ids.
+	std::unordered_map<uint64_t, int> edge_use;
+	const auto edge_key = [](uint32_t a, uint32_t b) {
+		return uint64_t(std::min(a, b)) << 32 | std::max(a, b);
+	};
+
+	for (uint32_t t = 0; t < triangle_alive.size(); t++) {
+		const uint32_t* v = &triangles[t * 3];
+		double n[3];
+		face_normal(&position[v[0] * 3], &position[v[1] * 3], &position[v[2] * 3], n);
+		const double length = std::sqrt(dot(n, n));
+		if (length > 0) {
+			const double area = length / 2;
+			n[0] /= length;
+			n[1] /= length;
+			n[2] /= length;
+			const double d = -dot(n, &position[v[0] * 3]);
+			for (int i = 0; i < 3; i++) {
+				quadrics[v[i]].add_plane(n[0], n[1], n[2], d, area);
+				quadrics[v[i]].area += area;
+			}
+		}
+
+		for (int i = 0; i < 3; i++) {
+			vertex_triangles[v[i]].push_back(t);
+			const uint32_t a = v[i], b = v[(i + 1) % 3];
+			edge_use[edge_key(a, b)]++;
+		}
+	}
+
+	// Constrain edges that belong to a single triangle.
+	for (uint32_t t = 0; t < triangle_alive.size(); t++) {
+		const uint32_t* v = &triangles[t * 3];
+		double n[3];
+		face_normal(&position[v[0] * 3], &position[v[1] * 3], &position[v[2] * 3], n);
+
+		for (int i = 0; i < 3; i++) {
+			const uint32_t a = v[i], b = v[(i + 1) % 3];
+			if (edge_use[edge_key(a, b)] != 1) {
+				continue;
+			}
+
+			const double* pa = &position[a * 3];
+			const double* pb = &position[b * 3];
+			const double edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+			double side[3];
+			cross(edge, n, side);
+			const double length = std::sqrt(dot(side, side));
+			if (length == 0) {
+				continue;
+			}
+			side[0] /= length;
+			side[1] /= length;
+			side[2] /= length;
+			const double weight = boundary_weight * dot(edge, edge);
+			const double d = -dot(side, pa);
+			quadrics[a].add_plane(side[0], side[1], side[2], d, weight);
+			quadrics[b].add_plane(side[0], side[1], side[2], d, weight);
+		}
+	}
+
+	for (uint32_t v = 0; v < vertex_triangles.size(); v++) {
+		push_edges(v);
+	}
+}
+
+size_t simplifier::simplify(size_t target)
+{
+	while (alive > target && !heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end());
+		const candidate c = heap.back();
+		heap.pop_back();
+
+		// Stale: one of the ends moved or disappeared since it was queued.
+		if (version[c.from] != c.from_version || version[c.to] != c.to_version
+			|| vertex_triangles[c.from].empty() || vertex_triangles[c.to].empty()) {
+			continue;
+		}
+		if (flips(c.from, c.to)) {
+			continue;
+		}
+
+		quadric merged = quadrics[c.from];
+		merged += quadrics[c.to];
+		if (merged.area > 0) {
+			max_error = std::max(max_error, std::sqrt(c.cost / merged.area));
+		}
+		collapse(c.from, c.to);
+	}
+
+	assert(alive == indices().size() / 3);
+	return alive;
+}
+
+std::vector<uint32_t> simplifier::indices() const
+{
+	std::vector<uint32_t> out;
+	out.reserve(alive * 3);
+	for (uint32_t t = 0; t < triangle_alive.size(); t++) {
+		if (triangle_alive[t]) {
+			out.insert(out.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+		}
+	}
+	return out;
+}
+
+void simplifier::push_edges(uint32_t vertex)
+{
+	for (uint32_t t : vertex_triangles[vertex]) {
+		for (int i = 0; i < 3; i++) {
+			const uint32_t other = triangles[t * 3 + i];
+			if (other != vertex) {
+				push_edge(vertex, other);
+			}
+		}
+	}
+}
+
+void simplifier::push_edge(uint32_t a, uint32_t b)
+{
+	quadric q = quadrics[a];
+	q += quadrics[b];
+
+	// Either end may stay, whichever deviates less.
+	const double to_b = q.evaluate(&position[b * 3]);
+	const double to_a = q.evaluate(&position[a * 3]);
+	if (to_b <= to_a) {
+		heap.push_back({ to_b, a, b, version[a], version[b] });
+	}
+	else {
+		heap.push_back({ to_a, b, a, version[b], version[a] });
+	}
+	std::push_heap(heap.begin(), heap.end());
+}
+
+bool simplifier::flips(uint32_t from, uint32_t to) const
+{
+	for (uint32_t t : vertex_triangles[from]) {
+		const uint32_t* v = &triangles[t * 3];
+		if (v[0] == to || v[1] == to || v[2] == to) {
+			continue;
+		}
+
+		const double* p[3];
+		const double* moved[3];
+		for (int i = 0; i < 3; i++) {
+			p[i] = &position[v[i] * 3];
+			moved[i] = v[i] == from ? &position[to * 3] : p[i];
+		}
+
+		double before[3], after[3];
+		face_normal(p[0], p[1], p[2], before);
+		face_normal(moved[0], moved[1], moved[2], after);
+		if (dot(before, after) <= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void simplifier::collapse(uint32_t from, uint32_t to)
+{
+	for (uint32_t t : vertex_triangles[from]) {
+		uint32_t* v = &triangles[t * 3];
+		if (v[0] == to || v[1] == to || v[2] == to) {
+			// Degenerate now, it leaves the lists of its other corners too so
+			// that no later collapse counts or tests it again.
+			triangle_alive[t] = 0;
+			alive--;
+			for (int i = 0; i < 3; i++) {
+				if (v[i] != from) {
+					auto& around = vertex_triangles[v[i]];
+					around.erase(std::remove(around.begin(), around.end(), t), around.end());
+				}
+			}
+			continue;
+		}
+		for (int i = 0; i < 3; i++) {
+			if (v[i] == from) {
+				v[i] = to;
+			}
+		}
+		vertex_triangles[to].push_back(t);
+	}
+	vertex_triangles[from].clear();
+
+	quadrics[to] += quadrics[from];
+	// Every queued edge of either end is stale now, the survivor's are queued again.
+	version[from]++;
+	version[to]++;
+	push_edges(to);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Edge collapse simplification with quadric error metrics, after Garland and
+// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997.
+// https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf
+//
+// Collapses move a vertex onto one of its neighbours, so every level keeps
+// using the original vertices and only the index list changes. Levels are
+// produced progressively: each call continues from the previous one.
+
+class simplifier
+{
+public:
+	simplifier(const std::vector<float>& positions, const std::vector<uint32_t>& indices);
+
+	// Collapses edges until at most target triangles remain or no collapse is
+	// possible without folding a triangle over. Returns the triangles left.
+	size_t simplify(size_t target);
+
+	// Current triangles, referencing the original vertices.
+	[[nodiscard]] std::vector<uint32_t> indices() const;
+	// Largest RMS distance to the original surface introduced so far.
+	[[nodiscard]] float error() const { return static_cast<float>(max_error); }
+
+private:
+	struct quadric {
+		double a[10] = {};		// upper triangle of the symmetric 4x4 matrix
+		double area = 0;
+
+		void add_plane(double nx, double ny, double nz, double d, double weight);
+		quadric& operator+=(const quadric& q);
+		[[nodiscard]] double evaluate(const double* p) const;
+	};
+
+	struct candidate {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t from_version;
+		uint32_t to_version;
+
+		bool operator<(const candidate& c) const { return cost > c.cost; }
+	};
+
+	void push_edges(uint32_t vertex);
+	void push_edge(uint32_t a, uint32_t b);
+	[[nodiscard]] bool flips(uint32_t from, uint32_t to) const;
+	void collapse(uint32_t from, uint32_t to);
+
+private:
+	std::vector<double> position;		// xyz per vertex
+	std::vector<uint32_t> triangles;	// three per triangle
+	std::vector<char> triangle_alive;
+	std::vector<std::vector<uint32_t>> vertex_triangles;
+	std::vector<quadric> quadrics;
+	std::vector<uint32_t> version;
+	std::vector<candidate> heap;
+	size_t alive = 0;
+	double max_error = 0;
+};
@@ -1,53 +1,153 @@
 #include "engine.h"
+#include "framehash.h"
+#include "framestore.h"
+#include "framegraph.h"
+#include "glprofile.h"
+#include "golden.h"
+#include "videosource.h"
+#include "mesh.h"
+#include "options.h"
+#include "sink.h"
+#include "readback.h"
 #include "rendertarget.h"
+#include "segments.h"
 #include "yuv.h"
+#ifdef RENDER_TEXT
+#include "text.h"
+#endif
 
-#include <gl/glew.h>
+#include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 
 namespace {
-#ifdef _DEBUG
-    void GLAPIENTRY
-        MessageCallback(GLenum source,
-            GLenum type,
-            GLuint id,
-            GLenum severity,
-            GLsizei length,
-            const GLchar* message,
-            const void* userParam)
+    // The caption of a frame, every {frame} replaced by its number.
+    std::string caption_text(const std::string& format, int frame_no)
     {
-        fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
-            (type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
-            type, severity, message);
+        constexpr std::string_view placeholder = "{frame}";
+        std::string line = format;
+        for (auto at = line.find(placeholder); at != std::string::npos; at = line.find(placeholder, at)) {
+            const auto number = std::to_string(frame_no);
+            line.replace(at, placeholder.size(), number);
+            at += number.size();
+        }
+        return line;
     }
-#endif
 
-    FILE* open_video(const std::string& filename, int width, int height) {
-        std::stringstream ss;
-        ss << "ffmpeg.exe -loglevel error "
-            << "-f rawvideo -pixel_format yuv420p -video_size "
-            << width << "*" << height << " -framerate 30 -i - "
-            << "-c:v h264_nvenc " << filename;
+    // Encodes the frames of a store to the output without rendering them again.
+    bool encode_store(const options& opts)
+    {
+        frame_store store;
+        if (!store.init(opts.encode)) {
+            return false;
+        }
+
+        const auto& info = store.info();
+        auto video = open_sink(opts.output, info.width, info.height, info.fps, opts.codec);
+        if (!video) {
+            return false;
+        }
 
-        auto cmd = ss.str();
-        std::cout << "CMD: " << cmd << std::endl;
-        return _popen(cmd.c_str(), "wb");
+        for (int i = 0; i < store.frames(); i++) {
+            if (!video->write(store.frame(i), store.frame_size())) {
+                std::cerr << "Cannot write frame " << i << " to " << opts.output << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Encoded " << store.frames() << " frames from " << opts.encode << std::endl;
+        return true;
+    }
+
+    // Hashes the frames of a raw I420 file on the CPU, the same hash the GPU writes to a
+    // manifest, and writes them to --manifest or compares them against --verify.
+    bool hash_raw(const options& opts, int width, int height)
+    {
+        std::ifstream in(opts.hash, std::ios::binary);
+        if (!in) {
+            std::cerr << "Cannot open " << opts.hash << std::endl;
+            return false;
+        }
+        std::ofstream manifest;
+        if (!opts.manifest.empty()) {
+            manifest.open(opts.manifest, std::ios::trunc);
+            if (!manifest) {
+                std::cerr << "Cannot write " << opts.manifest << std::endl;
+                return false;
+            }
+            write_manifest_header(manifest, width, height);
+        }
+        std::unordered_map<int, uint64_t> expected;
+        if (!opts.verify.empty() && !load_manifest(opts.verify, expected)) {
+            return false;
+        }
+
+        std::vector<unsigned char> data(static_cast<size_t>(width) * height * 3 / 2);
+        int frame = opts.first_frame;
+        int mismatches = 0;
+        while (in.read(reinterpret_cast<char*>(data.data()), data.size())) {
+            const uint64_t hash = hash_planes(data.data(), width, height);
+            if (manifest.is_open()) {
+                write_manifest_entry(manifest, frame, hash);
+            }
+            if (!opts.verify.empty()) {
+                const auto found = expected.find(frame);
+                if (found == expected.end() || found->second != hash) {
+                    std::cerr << "Frame " << frame << " does not match " << opts.verify << std::endl;
+                    mismatches++;
+                }
+            }
+            frame++;
+        }
+        if (in.gcount() != 0) {
+            std::cerr << opts.hash << " ends with a partial frame" << std::endl;
+            return false;
+        }
+
+        const int frames = frame - opts.first_frame;
+        std::cout << "Hashed " << frames << " frames from " << opts.hash << std::endl;
+        if (!opts.verify.empty()) {
+            std::cout << "Verify: " << frames - mismatches << " of " << frames
+                << " frames match " << opts.verify << std::endl;
+        }
+        return mismatches == 0 && frames > 0;
     }
 }
 
-int main(void)
+int main(int argc, char** argv)
 {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
     constexpr int width = 800;
     constexpr int height = 600;
 
+    if (!opts.encode.empty()) {
+        return encode_store(opts) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!opts.hash.empty()) {
+        return hash_raw(opts, width, height) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // The coordinator only starts the workers, they open their own windows.
+    if (opts.workers != 1) {
+        return render_segments(argc, argv, opts) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     GLFWwindow* window;
 
     /* Initialize the library */
@@ -55,6 +155,13 @@ int main(void)
         return -1;
 
     /* Create a windowed mode window and its OpenGL context */
+    if (opts.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+#ifdef _DEBUG
+    // Drivers only report warnings and performance issues to a debug context.
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
     window = glfwCreateWindow(width, height, "Hello World", NULL, NULL);
     if (!window)
     {
@@ -70,98 +177,417 @@ int main(void)
         return EXIT_FAILURE;
     }
 
-#ifdef _DEBUG
-    // During init, enable debug output
-    glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(MessageCallback, 0);
-#endif
+    enable_debug_output();
 
-    // Projection matrix: 45 Field of View, 4:3 ratio, display range: 0.1 unit <-> 100 units
-    const glm::mat4 Projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+    scene_file file;
+    if (!opts.scene.empty() && !load_scene_file(opts.scene, file)) {
+        return EXIT_FAILURE;
+    }
+
+    // Projection matrix: 45° Field of View, 4:3 ratio, display range: 0.1 unit <-> 100 units
+    const glm::mat4 Projection = glm::perspective(glm::radians(file.fov), (float)width / (float)height, 0.1f, 100.0f);
+
+    yuv rgb_to_yuv;
+    if (!rgb_to_yuv.init(width, height)) {
+        return EXIT_FAILURE;
+    }
 
-    constexpr int no_buffers = 2;
-    RenderTarget renderTargets[no_buffers];
+    // Every mesh is loaded once, however many objects use it.
+    std::map<std::string, std::unique_ptr<mesh>> meshes;
+    auto load_mesh = [&](const std::string& path) -> mesh* {
+        auto& loaded = meshes[path];
+        if (!loaded) {
+            loaded = std::make_unique<mesh>();
+            if (!loaded->init(path)) {
+                return nullptr;
+            }
+        }
+        return loaded.get();
+    };
 
-    for (int i = 0; i < no_buffers; i++) {
-        if (!renderTargets[i].init(width, height)) {
+    std::unique_ptr<engine> scene_engine;
+    if (!opts.scene.empty()) {
+        std::vector<drawable*> shapes;
+        for (const auto& object : file.objects) {
+            shapes.push_back(object.mesh.empty() ? nullptr : load_mesh(object.mesh));
+            if (!object.mesh.empty() && shapes.back() == nullptr) {
+                return EXIT_FAILURE;
+            }
+        }
+        scene_engine = std::make_unique<engine>(Projection, file, shapes);
+    }
+    else {
+        mesh* shape = nullptr;
+        if (!opts.mesh.empty() && (shape = load_mesh(opts.mesh)) == nullptr) {
             return EXIT_FAILURE;
         }
+        scene_engine = std::make_unique<engine>(Projection, opts.objects, shape);
     }
+    auto& engine = *scene_engine;
+    engine.set_lod(opts.lod_pixels, height);
+    engine.set_frame_rate(opts.fps);
 
-    yuv rgb_to_yuv;
-    if (!rgb_to_yuv.init(width, height)) {
+    std::unique_ptr<sink> video;
+    const bool resumed = opts.resume && std::filesystem::exists(opts.output);
+    if (resumed) {
+        auto store = std::make_unique<frame_store>();
+        if (!store->init(opts.output)) {
+            return EXIT_FAILURE;
+        }
+        const auto& info = store->info();
+        if (info.width != width || info.height != height || info.fps != static_cast<uint32_t>(opts.fps)
+            || info.first_frame != static_cast<uint32_t>(opts.first_frame)) {
+            std::cerr << opts.output << " was rendered with a different size, frame rate or first frame" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Only the frames after the last complete one are rendered.
+        const int stored = store->frames();
+        std::cout << "Resuming " << opts.output << " after " << stored << " frames" << std::endl;
+
+        // The manifest of the interrupted run can miss stored frames or list lost ones,
+        // so it is rewritten from the frames in the store.
+        if (!opts.manifest.empty()) {
+            std::ofstream rewritten(opts.manifest, std::ios::trunc);
+            write_manifest_header(rewritten, width, height);
+            for (int i = 0; i < stored; i++) {
+                write_manifest_entry(rewritten, opts.first_frame + i, hash_planes(store->frame(i), width, height));
+            }
+            if (!rewritten) {
+                std::cerr << "Cannot write " << opts.manifest << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        opts.first_frame += stored;
+        if (opts.frames > 0) {
+            opts.frames -= stored;
+            if (opts.frames <= 0) {
+                return EXIT_SUCCESS;
+            }
+        }
+        video = std::move(store);
+    }
+    else {
+        video = open_sink(opts.output, width, height, opts.fps, opts.codec, opts.first_frame, opts.frames);
+    }
+    if (!video) {
+        return EXIT_FAILURE;
+    }
+
+    // Frames to composite over, read ahead of the frame that shows them.
+    video_source source;
+    const bool composite = !opts.input.empty();
+    if (composite) {
+        if (!source.init(opts.input, width, height,
+            opts.input_nv12 ? video_source::format::nv12 : video_source::format::i420, opts.frames_in_flight)) {
+            return EXIT_FAILURE;
+        }
+        if (!source.ready()) {
+            std::cerr << "No frames in " << opts.input << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    golden reference;
+    if (!opts.golden.empty() && !reference.init(opts.golden, width, height)) {
         return EXIT_FAILURE;
     }
 
-    engine engine(Projection);
-    int idx = 0;
+    // Per-frame CPU time and output hash, kept in memory until exit.
+    std::vector<double> frame_ms;
+    std::vector<uint64_t> frame_hash;
+    frame_ms.reserve(opts.frames);
+    frame_hash.reserve(opts.frames);
 
-    std::vector<GLubyte> Y;
-    std::vector<GLubyte> U;
-    std::vector<GLubyte> V;
-    constexpr size_t Y_size = width * height;
-    constexpr size_t U_size = width * height / 4;
-    constexpr size_t V_size = width * height / 4;
-    Y.reserve(Y_size);
-    U.reserve(U_size);
-    V.reserve(V_size);
+    // Hashes computed on the GPU, written to the manifest and compared against --verify.
+    // A resumed manifest already holds the stored frames.
+    std::ofstream manifest;
+    if (!opts.manifest.empty()) {
+        manifest.open(opts.manifest, resumed ? std::ios::app : std::ios::trunc);
+        if (!manifest) {
+            std::cerr << "Cannot write " << opts.manifest << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (!resumed) {
+            write_manifest_header(manifest, width, height);
+        }
+    }
+    std::unordered_map<int, uint64_t> expected;
+    if (!opts.verify.empty() && !load_manifest(opts.verify, expected)) {
+        return EXIT_FAILURE;
+    }
+    const bool hashing = manifest.is_open() || !opts.verify.empty();
+    int hashed = 0;
+    int mismatches = 0;
+    auto on_hash = [&](uint64_t hash) {
+        const int frame = opts.first_frame + hashed++;
+        if (manifest.is_open()) {
+            write_manifest_entry(manifest, frame, hash);
+        }
+        if (!opts.verify.empty()) {
+            const auto found = expected.find(frame);
+            if (found == expected.end() || found->second != hash) {
+                std::cerr << "Frame " << frame << " does not match " << opts.verify << std::endl;
+                mismatches++;
+            }
+        }
+    };
 
-    auto filename = "test.mkv";
-    if (std::filesystem::exists(filename)) {
-        std::filesystem::remove(filename);
+    // Frames only verified against a manifest never leave the GPU. A failed write, e.g. a
+    // full disk or ffmpeg exiting, ends the render.
+    bool write_failed = false;
+    auto consume = [&](const GLubyte* data, size_t size) {
+        if (write_failed) {
+            return;
+        }
+        if (!opts.golden.empty()) {
+            frame_hash.push_back(reference.compare(data, size).hash);
+        }
+        else if (!opts.timings.empty()) {
+            frame_hash.push_back(hash_planes(data, width, height));
+        }
+        if (!video->write(data, size)) {
+            std::cerr << "Cannot write frame to " << opts.output << std::endl;
+            write_failed = true;
+        }
+    };
+    const bool gpu_only = hashing && opts.output == "null" && opts.golden.empty() && opts.timings.empty();
+
+    readback frames;
+    if (!frames.init(width, height, opts.frames_in_flight,
+        gpu_only ? readback::consume_fn() : consume,
+        hashing ? readback::hash_fn(on_hash) : nullptr)) {
+        return EXIT_FAILURE;
     }
-    auto video = open_video("test.mkv", width, height);
-    int frame_no = 0;
-    auto started_at = std::chrono::high_resolution_clock::now();
 
-    while (!glfwWindowShouldClose(window))
-    {
-        const int tail = (idx + 1) % no_buffers;
-        engine.update(glfwGetTime());
+    // Render result to screen as well, the blit pass is culled from the graph otherwise.
+    constexpr bool preview = false;
 
-        renderTargets[idx].Begin();
-        engine.render();
-        renderTargets[idx].End();
+#ifdef RENDER_TEXT
+    // Glyphs are rasterized when the caption first needs them, the atlas never grows.
+    font caption_font;
+    glyph_cache glyphs;
+    text caption;
+    if (!opts.text.empty() && (!caption_font.init(opts.font, opts.font_size)
+        || !glyphs.init(caption_font, 512) || !caption.init(glyphs, width, height))) {
+        return EXIT_FAILURE;
+    }
+#else
+    if (!opts.text.empty()) {
+        std::cerr << "Built without FreeType, --text is not available" << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+    // A caption with the frame number changes every frame.
+    const bool dynamic_text = opts.text.find("{frame}") != std::string::npos;
+    std::string caption_line;
 
-        // TODO: Gamma-Correction : Already in linear RGB, should not be needed!?
-        // https://nicolbolas.github.io/oldtut/Texturing/Tutorial%2016.html
-        // https://learnopengl.com/Advanced-Lighting/Gamma-Correction
+    framegraph graph;
+    const auto scene = graph.create_target("scene", width, height);
+    const auto planes = graph.import("yuv planes");
+    const auto screen = graph.import("screen");
+    if (preview) {
+        graph.mark_output(screen);
+    }
+
+    std::vector<framegraph::use> scene_reads;
+    if (composite) {
+        const auto footage = graph.import("video planes");
+        scene_reads.push_back({ footage, framegraph::access::sampled });
 
-        // TODO: Convert RGB to YUV 4:2:0 in a fragment shader
-        // https://stackoverflow.com/questions/7901519/how-to-use-opengl-fragment-shader-to-convert-rgb-to-yuv420
-        rgb_to_yuv.Begin();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        rgb_to_yuv.ConvertToYUV(renderTargets[tail].get_texture());
-        rgb_to_yuv.End();
+        graph.add_pass("upload", {}, { { footage, framegraph::access::transfer } },
+            [&](const framegraph::registry&) {
+                source.upload();
+            });
+    }
 
-        // Render result to screen
-        //glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        //renderTargets[0].RenderTexture(width, height, renderTargets[tail].get_texture());
-        //glfwSwapBuffers(window);
+    // Lit scenes draw their shadow maps into depth targets the lights own.
+    if (engine.lit()) {
+        const auto shadow_maps = graph.import("shadow maps");
+        scene_reads.push_back({ shadow_maps, framegraph::access::sampled });
 
-        glfwPollEvents();
+        graph.add_pass("shadows", {}, { { shadow_maps, framegraph::access::attachment } },
+            [&](const framegraph::registry&) {
+                engine.render_shadows();
+            });
+    }
+
+    graph.add_pass("scene", scene_reads, { { scene, framegraph::access::attachment } },
+        [&](const framegraph::registry& res) {
+            res.target(scene).Begin();
+            if (composite) {
+                res.target(scene).RenderYUV(source.get_texture(0), source.get_texture(1), source.get_texture(2));
+            }
+            engine.render(!composite);
+#ifdef RENDER_TEXT
+            if (!opts.text.empty()) {
+                caption.add(caption_line, 20, height - 20);
+                caption.draw();
+            }
+#endif
+            res.target(scene).End();
+        });
+
+    // TODO: Gamma-Correction : Already in linear RGB, should not be needed!?
+    // https://nicolbolas.github.io/oldtut/Texturing/Tutorial%2016.html
+    // https://learnopengl.com/Advanced-Lighting/Gamma-Correction
 
-        auto tex = rgb_to_yuv.get_texture(0);
-        glGetTextureImage(tex, 0, GL_RED, GL_UNSIGNED_BYTE, Y_size, Y.data());
-        tex = rgb_to_yuv.get_texture(1);
-        glGenerateTextureMipmap(tex);
-        glGetTextureImage(tex, 1, GL_RED, GL_UNSIGNED_BYTE, U_size, U.data());
-        tex = rgb_to_yuv.get_texture(2);
-        glGenerateTextureMipmap(tex);
-        glGetTextureImage(tex, 1, GL_RED, GL_UNSIGNED_BYTE, V_size, V.data());
+    // Convert RGB to YUV 4:2:0 in a fragment shader
+    // https://stackoverflow.com/questions/7901519/how-to-use-opengl-fragment-shader-to-convert-rgb-to-yuv420
+    graph.add_pass("convert", { { scene, framegraph::access::sampled } }, { { planes, framegraph::access::attachment } },
+        [&](const framegraph::registry& res) {
+            rgb_to_yuv.Begin();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            rgb_to_yuv.ConvertToYUV(res.texture(scene));
+            rgb_to_yuv.End();
+        });
 
-        _fwrite_nolock(Y.data(), 1, Y_size, video);
-        _fwrite_nolock(U.data(), 1, U_size, video);
-        _fwrite_nolock(V.data(), 1, V_size, video);
+    graph.add_pass("blit", { { scene, framegraph::access::sampled } }, { { screen, framegraph::access::attachment } },
+        [&](const framegraph::registry& res) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            res.target(scene).RenderTexture(width, height);
+            glfwSwapBuffers(window);
+        });
+
+    graph.add_pass("readback", { { planes, framegraph::access::readback } }, {},
+        [&](const framegraph::registry&) {
+            frames.push(rgb_to_yuv);
+        }, true);
+
+    if (!graph.compile()) {
+        return EXIT_FAILURE;
+    }
+    graph.print(std::cout);
 
-        idx = tail;
+    // A segment starts later in the timeline, including the frames held before it.
+    int frame_no = opts.first_frame;
+    int held_frames = std::max(0, std::min(frame_no - 1, opts.hold_last) - opts.hold_first);
+    int rendered = 0;
+    scene::cull_stats culling;
+    int64_t triangles = 0;
+    int64_t full_triangles = 0;
+    shadows::stats shadowing;
+    auto started_at = std::chrono::high_resolution_clock::now();
+
+    while (!glfwWindowShouldClose(window) && !write_failed && (opts.frames == 0 || frame_no < opts.first_frame + opts.frames))
+    {
+        const auto frame_start = std::chrono::high_resolution_clock::now();
+        if (frame_no > opts.hold_first && frame_no <= opts.hold_last) {
+            held_frames++;
+        }
+        engine.update(opts.deterministic ? static_cast<double>(frame_no - held_frames) / opts.fps : glfwGetTime());
+
+        // The input ends the video when it runs out.
+        if (composite && !source.ready()) {
+            break;
+        }
+
+        // A frame identical to the previous one is sent again without touching the GPU.
+        if (!opts.text.empty()) {
+            caption_line = caption_text(opts.text, frame_no);
+        }
+        if (engine.changed() || composite || dynamic_text || frame_no == opts.first_frame) {
+            graph.execute();
+            if (composite) {
+                source.read_next();
+            }
+#ifdef RENDER_GL_PROFILE
+            gl_profile::end_frame();
+#endif
+            const auto& stats = engine.get_cull_stats();
+            culling.tested += stats.tested;
+            culling.culled += stats.culled;
+            culling.drawn += stats.drawn;
+            triangles += engine.get_lod_stats().triangles;
+            full_triangles += engine.get_lod_stats().full_triangles;
+            shadowing.static_renders += engine.get_shadow_stats().static_renders;
+            shadowing.moving_renders += engine.get_shadow_stats().moving_renders;
+            shadowing.casters += engine.get_shadow_stats().casters;
+            rendered++;
+        }
+        else {
+            frames.repeat();
+        }
+        glfwPollEvents();
         frame_no++;
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - frame_start).count());
     }
 
+    // Frames still in flight belong to the video as well.
+    frames.drain();
+
     std::chrono::duration<double> elapsed_seconds = std::chrono::high_resolution_clock::now() - started_at;
-    std::cout << "FPS: " << frame_no / elapsed_seconds.count() << std::endl;
+    std::cout << "FPS: " << (frame_no - opts.first_frame) / elapsed_seconds.count() << std::endl;
+
+    const auto& stats = frames.get_stats();
+    std::cout << "Frames in flight: " << frames.depth()
+        << ", latency: " << stats.latency_ms << " ms (max " << stats.max_latency_ms << " ms)"
+        << ", blocked on fences: " << stats.wait_ms << " ms"
+        << ", unchanged frames repeated: " << stats.repeats << std::endl;
+
+    if (composite) {
+        const auto& input = source.get_stats();
+        std::cout << "Input frames: " << input.frames << ", reading: " << input.read_ms
+            << " ms, blocked on fences: " << input.wait_ms << " ms" << std::endl;
+    }
+
+    if (rendered > 0) {
+        std::cout << "Objects per frame: " << engine.object_count()
+            << ", tested: " << culling.tested / rendered
+            << ", culled: " << culling.culled / rendered
+            << ", drawn: " << culling.drawn / rendered << std::endl;
+        std::cout << "Triangles per frame: " << triangles / rendered
+            << " of " << full_triangles / rendered << " at full detail" << std::endl;
+        if (engine.lit()) {
+            std::cout << "Shadow maps: " << shadowing.static_renders << " cache redraws, "
+                << shadowing.moving_renders << " with moving casters, "
+                << shadowing.casters / rendered << " casters per frame" << std::endl;
+        }
+    }
+
+#ifdef RENDER_TEXT
+    if (!opts.text.empty()) {
+        const auto& cached = glyphs.get_stats();
+        std::cout << "Glyphs: " << cached.hits << " hits, " << cached.misses << " misses, "
+            << cached.evictions << " shelves evicted, " << cached.uploads << " uploads of "
+            << cached.bytes_uploaded / 1024 << " KB" << std::endl;
+    }
+#endif
+
+#ifdef RENDER_GL_PROFILE
+    gl_profile::print(std::cout);
+#endif
+
+    if (!opts.timings.empty()) {
+        std::ofstream csv(opts.timings);
+        csv << "frame,ms,hash" << std::endl;
+        for (size_t i = 0; i < frame_ms.size(); i++) {
+            csv << opts.first_frame + i << "," << frame_ms[i] << ",";
+            if (i < frame_hash.size()) {
+                csv << std::hex << frame_hash[i] << std::dec;
+            }
+            csv << std::endl;
+        }
+    }
+
+    int status = write_failed ? EXIT_FAILURE : 0;
+    if (!opts.golden.empty()) {
+        std::cout << "Golden: " << reference.get_frames() - reference.get_failures()
+            << " of " << reference.get_frames() << " frames match " << opts.golden << std::endl;
+        if (reference.get_failures() > 0) {
+            status = EXIT_FAILURE;
+        }
+    }
+    if (!opts.verify.empty()) {
+        std::cout << "Verify: " << hashed - mismatches << " of " << hashed
+            << " frames match " << opts.verify << std::endl;
+        if (mismatches > 0) {
+            status = EXIT_FAILURE;
+        }
+    }
 
-    _pclose(video);
+    video.reset();
     glfwTerminate();
-    return 0;
+    return status;
 }
@@ -0,0 +1,189 @@
+#include "animation.h"
+#include "transforms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+	// Forward steps tried from the cursor before searching, plenty when frames are shorter than keys.
+	constexpr uint32_t linear_probe = 4;
+
+	glm::vec4 slerp(const glm::vec4& a, glm::vec4 b, float t) {
+		float cosine = glm::dot(a, b);
+		// Take the short way around.
+		if (cosine < 0) {
+			b = b * -1.0f;
+			cosine = -cosine;
+		}
+
+		// Nearly parallel, lerp is accurate and avoids dividing by sin(0).
+		if (cosine > 0.9995f) {
+			const glm::vec4 q = a + (b - a) * t;
+			return q / glm::length(q);
+		}
+
+		const float angle = std::acos(cosine);
+		const float s = std::sin(angle);
+		return a * (std::sin((1 - t) * angle) / s) + b * (std::sin(t * angle) / s);
+	}
+}
+
+int animation::add_channel(int object, property what)
+{
+	channels.push_back({ object, what, 0, 0 });
+	staged_times.emplace_back();
+	staged_values.emplace_back();
+	staged_modes.emplace_back();
+	return static_cast<int>(channels.size()) - 1;
+}
+
+void animation::add_key(int channel, float time, const glm::vec4& value, interpolation mode)
+{
+	staged_times[channel].push_back(time);
+	staged_values[channel].push_back(value);
+	staged_modes[channel].push_back(mode);
+}
+
+void animation::finish(int objects)
+{
+	// Camera first, then by object, so every object's channels are one contiguous range.
+	std::vector<int> order(channels.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(),
+		[&](int a, int b) { return channels[a].object < channels[b].object; });
+
+	std::vector<channel> sorted;
+	sorted.reserve(channels.size());
+	key_times.clear();
+	key_values.clear();
+	key_modes.clear();
+
+	for (int c : order) {
+		channel ch = channels[c];
+		if (staged_times[c].empty()) {
+			continue;
+		}
+		ch.first = static_cast<uint32_t>(key_times.size());
+		ch.count = static_cast<uint32_t>(staged_times[c].size());
+		key_times.insert(key_times.end(), staged_times[c].begin(), staged_times[c].end());
+		key_values.insert(key_values.end(), staged_values[c].begin(), staged_values[c].end());
+		key_modes.insert(key_modes.end(), staged_modes[c].begin(), staged_modes[c].end());
+		sorted.push_back(ch);
+	}
+
+	channels = std::move(sorted);
+	staged_times.clear();
+	staged_values.clear();
+	staged_modes.clear();
+	cursors.assign(channels.size(), 0);
+
+	camera_channels = 0;
+	while (camera_channels < channels.size() && channels[camera_channels].object == camera) {
+		camera_channels++;
+	}
+
+	object_channels.assign(objects + 1, static_cast<uint32_t>(channels.size()));
+	for (uint32_t c = static_cast<uint32_t>(channels.size()); c-- > camera_channels;) {
+		object_channels[channels[c].object] = c;
+	}
+	// Objects without channels start where the next one does.
+	for (int o = objects; o-- > 0;) {
+		object_channels[o] = std::min(object_channels[o], object_channels[o + 1]);
+	}
+}
+
+void animation::sample(double time, int begin, int end, transforms& out)
+{
+	const float t = static_cast<float>(time);
+	for (uint32_t c = object_channels[begin]; c < object_channels[end]; c++) {
+		const glm::vec4 value = evaluate(c, t);
+		const int object = channels[c].object;
+		switch (channels[c].what) {
+		case property::position:
+			out.set_position(object, glm::vec3(value));
+			break;
+		case property::rotation:
+			out.set_rotation(object, value);
+			break;
+		case property::scale:
+			out.set_scale(object, glm::vec3(value));
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void animation::sample_camera(double time, glm::vec3& eye, glm::vec3& target)
+{
+	const float t = static_cast<float>(time);
+	for (uint32_t c = 0; c < camera_channels; c++) {
+		const glm::vec3 value(evaluate(c, t));
+		if (channels[c].what == property::eye) {
+			eye = value;
+		}
+		else if (channels[c].what == property::target) {
+			target = value;
+		}
+	}
+}
+
+bool animation::changes(double from, double to) const
+{
+	const float lo = static_cast<float>(std::min(from, to));
+	const float hi = static_cast<float>(std::max(from, to));
+	if (lo == hi) {
+		return false;
+	}
+	for (const auto& c : channels) {
+		if (hi > key_times[c.first] && lo < key_times[c.first + c.count - 1]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t animation::find(int id, float time)
+{
+	const auto& ch = channels[id];
+	const float* times = &key_times[ch.first];
+	uint32_t k = cursors[id];
+
+	// Still at or past the cached key: walk forward a few keys.
+	if (times[k] <= time) {
+		for (uint32_t step = 0; step < linear_probe; step++) {
+			if (k + 1 == ch.count || times[k + 1] > time) {
+				cursors[id] = k;
+				return k;
+			}
+			k++;
+		}
+	}
+
+	// Last key at or before time, the first key before the timeline starts.
+	const float* after = std::upper_bound(times, times + ch.count, time);
+	k = after == times ? 0 : static_cast<uint32_t>(after - times - 1);
+	cursors[id] = k;
+	return k;
+}
+
+glm::vec4 animation::evaluate(int id, float time)
+{
+	const auto& ch = channels[id];
+	const uint32_t k = find(id, time);
+	const uint32_t key = ch.first + k;
+
+	if (k + 1 == ch.count || time <= key_times[key] || key_modes[key] == interpolation::step) {
+		return key_values[key];
+	}
+
+	float t = (time - key_times[key]) / (key_times[key + 1] - key_times[key]);
+	if (key_modes[key] == interpolation::ease) {
+		t = t * t * (3 - 2 * t);
+	}
+
+	const glm::vec4& a = key_values[key];
+	const glm::vec4& b = key_values[key + 1];
+	return ch.what == property::rotation ? slerp(a, b, t) : a + (b - a) * t;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class transforms;
+
+// Keyframed channels of a timeline, flattened into arrays: key times are
+// contiguous per channel for searching, values and interpolation modes sit in
+// parallel arrays. Every channel remembers the key it was last sampled at, so
+// playing forward costs one or two comparisons per channel and only jumps fall
+// back to a binary search.
+
+class animation
+{
+public:
+	enum class property : uint8_t {
+		position,
+		rotation,	// quaternion x, y, z, w
+		scale,
+		eye,		// camera only
+		target,		// camera only
+	};
+
+	enum class interpolation : uint8_t {
+		step,		// hold the value until the next key
+		linear,		// lerp, slerp for rotations
+		ease,		// linear with smoothstep timing
+	};
+
+	// Object of camera channels.
+	static constexpr int camera = -1;
+
+	// Keys of one channel have to be added in time order, channels of an object
+	// may be added in any order. finish() must be called before sampling.
+	int add_channel(int object, property what);
+	void add_key(int channel, float time, const glm::vec4& value, interpolation mode = interpolation::linear);
+	void finish(int objects);
+
+	// Channels of objects [begin, end) written into the transforms. Ranges may be
+	// sampled concurrently as long as they do not overlap.
+	void sample(double time, int begin, int end, transforms& out);
+	void sample_camera(double time, glm::vec3& eye, glm::vec3& target);
+
+	// True if any channel, the camera included, can have another value at to than at from.
+	// A channel holds its first key before it and its last key after it.
+	[[nodiscard]] bool changes(double from, double to) const;
+
+	[[nodiscard]] bool empty() const { return channels.empty(); }
+	// True if the object has keys of its own, only after finish().
+	[[nodiscard]] bool animated(int object) const { return object_channels[object] != object_channels[object + 1]; }
+	[[nodiscard]] int channel_count() const { return static_cast<int>(channels.size()); }
+
+private:
+	struct channel {
+		int object;
+		property what;
+		uint32_t first;		// into the key arrays
+		uint32_t count;
+	};
+
+	[[nodiscard]] glm::vec4 evaluate(int id, float time);
+	[[nodiscard]] uint32_t find(int id, float time);
+
+private:
+	// Staging until finish(), then sorted by object.
+	std::vector<channel> channels;
+	std::vector<std::vector<float>> staged_times;
+	std::vector<std::vector<glm::vec4>> staged_values;
+	std::vector<std::vector<interpolation>> staged_modes;
+
+	// First channel of every object, camera channels come before object 0.
+	std::vector<uint32_t> object_channels;
+	uint32_t camera_channels = 0;
+
+	std::vector<float> key_times;
+	std::vector<glm::vec4> key_values;
+	std::vector<interpolation> key_modes;	// from this key to the next
+	std::vector<uint32_t> cursors;			// per channel, key index relative to first
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// Axis aligned bounding boxes, one at a time or as a structure of arrays for batch tests.
+
+struct aabb
+{
+	glm::vec3 min = glm::vec3(0);
+	glm::vec3 max = glm::vec3(0);
+
+	[[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+	[[nodiscard]] glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+	[[nodiscard]] float area() const {
+		const glm::vec3 d = max - min;
+		return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+};
+
+[[nodiscard]] inline aabb merge(const aabb& a, const aabb& b)
+{
+	return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+// Box around the transformed box, center and extent form.
+// https://zeux.io/2010/10/17/aabb-from-obb-with-component-wise-abs/
+[[nodiscard]] inline aabb transform(const aabb& box, const glm::mat4& m)
+{
+	const glm::vec3 c = box.center();
+	const glm::vec3 e = box.extent();
+	const glm::vec3 center = glm::vec3(m * glm::vec4(c, 1));
+	const glm::vec3 extent(
+		std::abs(m[0][0]) * e.x + std::abs(m[1][0]) * e.y + std::abs(m[2][0]) * e.z,
+		std::abs(m[0][1]) * e.x + std::abs(m[1][1]) * e.y + std::abs(m[2][1]) * e.z,
+		std::abs(m[0][2]) * e.x + std::abs(m[1][2]) * e.y + std::abs(m[2][2]) * e.z);
+	return { center - extent, center + extent };
+}
+
+struct aabb_soa
+{
+	std::vector<float> min_x, min_y, min_z;
+	std::vector<float> max_x, max_y, max_z;
+
+	void resize(size_t size) {
+		// Padded to a multiple of 8 so that SIMD loops can always load full registers.
+		const size_t padded = (size + 7) & ~size_t(7);
+		for (auto* v : { &min_x, &min_y, &min_z, &max_x, &max_y, &max_z }) {
+			v->resize(padded, 0.0f);
+		}
+	}
+
+	void set(size_t i, const aabb& box) {
+		min_x[i] = box.min.x; min_y[i] = box.min.y; min_z[i] = box.min.z;
+		max_x[i] = box.max.x; max_y[i] = box.max.y; max_z[i] = box.max.z;
+	}
+};
@@ -0,0 +1,120 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <functional>
+
+void bvh::build(const std::vector<aabb>& boxes)
+{
+	const int count = static_cast<int>(boxes.size());
+
+	tree.clear();
+	objects.resize(count);
+	for (int i = 0; i < count; i++) {
+		objects[i] = i;
+	}
+
+	if (count > 0) {
+		tree.reserve(2 * (count / leaf_size + 1));
+		split(boxes, 0, count, -1);
+	}
+
+	slot_of.resize(count);
+	leaf_of.resize(count);
+	for (int n = 0; n < static_cast<int>(tree.size()); n++) {
+		if (!tree[n].leaf()) {
+			continue;
+		}
+		for (int i = tree[n].first; i < tree[n].first + tree[n].count; i++) {
+			slot_of[objects[i]] = i;
+			leaf_of[objects[i]] = n;
+		}
+	}
+
+	refit_mark.assign(tree.size(), 0);
+	built_area = tree.empty() ? 0 : tree[0].bounds.area();
+}
+
+int bvh::split(const std::vector<aabb>& boxes, int first, int count, int parent)
+{
+	const int index = static_cast<int>(tree.size());
+	tree.emplace_back();
+	tree[index].first = first;
+	tree[index].count = count;
+	tree[index].parent = parent;
+
+	aabb bounds = boxes[objects[first]];
+	aabb centers{ bounds.center(), bounds.center() };
+	for (int i = first + 1; i < first + count; i++) {
+		const aabb& box = boxes[objects[i]];
+		bounds = merge(bounds, box);
+		centers = merge(centers, { box.center(), box.center() });
+	}
+	tree[index].bounds = bounds;
+
+	if (count <= leaf_size) {
+		return index;
+	}
+
+	// Median split along the axis where the centers spread the most.
+	const glm::vec3 spread = centers.max - centers.min;
+	const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+	const int half = count / 2;
+	std::nth_element(objects.begin() + first, objects.begin() + first + half, objects.begin() + first + count,
+		[&](int a, int b) { return boxes[a].center()[axis] < boxes[b].center()[axis]; });
+
+	split(boxes, first, half, index);
+	const int right = split(boxes, first + half, count - half, index);
+	tree[index].right = right;
+	return index;
+}
+
+void bvh::refit(const std::vector<aabb>& boxes, const std::vector<int>& moved)
+{
+	if (tree.empty()) {
+		return;
+	}
+
+	// Everything moved: one bottom up pass, children always come after their parent.
+	if (moved.size() * 4 >= objects.size()) {
+		for (int n = static_cast<int>(tree.size()) - 1; n >= 0; n--) {
+			refit_node(n, boxes);
+		}
+		return;
+	}
+
+	// Otherwise mark the touched leaves and their ancestors, stopping where an
+	// earlier object already marked the path, then refit those nodes bottom up.
+	refit_pass++;
+	dirty.clear();
+	for (int object : moved) {
+		for (int n = leaf_of[object]; n >= 0 && refit_mark[n] != refit_pass; n = tree[n].parent) {
+			refit_mark[n] = refit_pass;
+			dirty.push_back(n);
+		}
+	}
+
+	std::sort(dirty.begin(), dirty.end(), std::greater<int>());
+	for (int n : dirty) {
+		refit_node(n, boxes);
+	}
+}
+
+void bvh::refit_node(int index, const std::vector<aabb>& boxes)
+{
+	node& n = tree[index];
+	if (n.leaf()) {
+		aabb bounds = boxes[objects[n.first]];
+		for (int i = n.first + 1; i < n.first + n.count; i++) {
+			bounds = merge(bounds, boxes[objects[i]]);
+		}
+		n.bounds = bounds;
+	}
+	else {
+		n.bounds = merge(tree[index + 1].bounds, tree[n.right].bounds);
+	}
+}
+
+bool bvh::degraded() const
+{
+	return !tree.empty() && tree[0].bounds.area() > 2 * built_area;
+}
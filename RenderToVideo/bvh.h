@@ -0,0 +1,54 @@
+#pragma once
+#include "bounds.h"
+
+#include <vector>
+
+// Bounding volume hierarchy over a set of boxes, stored depth first in one array.
+// Leaves reference a contiguous range of the leaf order, so every subtree covers a
+// contiguous range as well. Moving objects are handled by refitting the bounds;
+// the tree is rebuilt once refitting has let it grow too far from its built size.
+// https://jacco.ompf2.com/2022/04/13/how-to-build-a-bvh-part-1-basics/
+
+class bvh
+{
+public:
+	struct node {
+		aabb bounds;
+		int first = 0;		// into order()
+		int count = 0;		// objects below this node
+		int right = -1;		// second child, the first one follows this node; -1 for leaves
+		int parent = -1;
+
+		[[nodiscard]] bool leaf() const { return right < 0; }
+	};
+
+	static constexpr int leaf_size = 8;
+
+	void build(const std::vector<aabb>& boxes);
+
+	// Updates the bounds of the leaves holding the moved objects and their ancestors.
+	void refit(const std::vector<aabb>& boxes, const std::vector<int>& moved);
+
+	// True when refitting made the root much larger than it was when built.
+	[[nodiscard]] bool degraded() const;
+
+	[[nodiscard]] const std::vector<node>& nodes() const { return tree; }
+	// Object index for each position in leaf order.
+	[[nodiscard]] const std::vector<int>& order() const { return objects; }
+	// Position in leaf order of each object.
+	[[nodiscard]] const std::vector<int>& positions() const { return slot_of; }
+
+private:
+	int split(const std::vector<aabb>& boxes, int first, int count, int parent);
+	void refit_node(int index, const std::vector<aabb>& boxes);
+
+private:
+	std::vector<node> tree;
+	std::vector<int> objects;
+	std::vector<int> slot_of;
+	std::vector<int> leaf_of;
+	std::vector<unsigned> refit_mark;
+	std::vector<int> dirty;
+	unsigned refit_pass = 0;
+	float built_area = 0;
+};
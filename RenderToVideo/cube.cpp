@@ -2,6 +2,7 @@
 
 #include <GL/glew.h>
 #include "cube.h"
+#include "glprofile.h"
 
 namespace {
     // Our vertices. Three consecutive floats give a 3D vertex; Three consecutive vertices give a triangle.
@@ -118,7 +119,7 @@ cube::cube()
     glBindVertexArray(0);
 }
 
-void cube::draw()
+void cube::draw(int)
 {
     glBindVertexArray(vao);
     glDrawArrays(GL_TRIANGLES, 0, 12 * 3);
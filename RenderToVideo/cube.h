@@ -1,13 +1,17 @@
 #pragma once
 
+#include "drawable.h"
+
 #include <GL/glew.h>
 
-class cube {
+class cube : public drawable {
 public:
 	cube();
-	void draw();
+	void draw(int lod = 0) override;
+	[[nodiscard]] int triangles(int lod) const override { return 12; }
+	[[nodiscard]] aabb bounds() const override { return { glm::vec3(-1), glm::vec3(1) }; }
 private:
 	GLuint vao = 0;
 	GLuint vert_buffer = 0;
 	GLuint color_buffer = 0;
-};
\ No newline at end of file
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "bounds.h"
+
+#include <glm/glm.hpp>
+
+// Geometry the scene can place, built in or loaded from a mesh file.
+
+class drawable
+{
+public:
+	virtual ~drawable() = default;
+
+	// Level 0 is the full geometry, every level after it is coarser.
+	virtual void draw(int lod = 0) = 0;
+	[[nodiscard]] virtual int lods() const { return 1; }
+	// Distance the level deviates from the full geometry, in object space.
+	[[nodiscard]] virtual float lod_error(int lod) const { return 0.0f; }
+	[[nodiscard]] virtual int triangles(int lod) const = 0;
+
+	// Object space bounds of the decoded positions.
+	[[nodiscard]] virtual aabb bounds() const = 0;
+	// Maps the vertex positions as stored to object space.
+	[[nodiscard]] virtual glm::mat4 decode() const { return glm::mat4(1.0f); }
+};
@@ -1,29 +1,51 @@
 #include "engine.h"
 #include "cube.h"
+#include "glprofile.h"
 
-#include <gl/glew.h>
+#include <GL/glew.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 namespace {
 	// https://learnopengl.com/Advanced-OpenGL/Framebuffers
 	// https://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
 
-	GLuint program() {
+	const char* unlit_frag_source = R"(
+		#version 430 core
+		in vec3 fragmentColor;
+		out vec3 color;
+		void main()
+		{
+			color = fragmentColor;
+		}
+		)";
+
+	GLuint program(const char* frag_shader_source) {
 		const char* vert_shader_source = R"(
-		#version 330 core
+		#version 430 core
 		layout(location = 0) in vec3 pos;
 		layout(location = 1) in vec3 vertexColor;
 
+		// Model matrices of every object, written by engine::update.
+		layout(std430, binding = 0) readonly buffer Models {
+			mat4 model[];
+		};
+
 		// Values that stay constant for the whole mesh.
-		uniform mat4 MVP;
+		uniform mat4 ViewProj;
+		uniform mat4 Decode;
+		uniform int object;
 
 		out vec3 fragmentColor;
+		out vec3 worldPosition;
 
 		void main()
 		{
 			// Output position of the vertex, in clip space: MVP * position
-			gl_Position =  MVP * vec4(pos, 1);
+			gl_Position =  ViewProj * model[object] * Decode * vec4(pos, 1);
+			worldPosition = vec3(model[object] * Decode * vec4(pos, 1));
 
 			// The color of each vertex will be interpolated
 			// to produce the color of each fragment
@@ -31,21 +53,13 @@ namespace {
 		}
 	)";
 
-		const char* frag_shader_source = R"(
-		#version 330 core
-		in vec3 fragmentColor;
-		out vec3 color;
-		void main()
-		{
-			color = fragmentColor;
-		}
-		)";
-
 		GLuint vert = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vert, 1, &vert_shader_source, nullptr);
+		glCompileShader(vert);
 
 		GLuint frag = glCreateShader(GL_FRAGMENT_SHADER);
 		glShaderSource(frag, 1, &frag_shader_source, nullptr);
+		glCompileShader(frag);
 
 		GLuint prog = glCreateProgram();
 		glAttachShader(prog, vert);
@@ -62,57 +76,264 @@ namespace {
 		return prog;
 	}
 
-#ifdef _DEBUG
-	void GLAPIENTRY
-		MessageCallback(GLenum source,
-			GLenum type,
-			GLuint id,
-			GLenum severity,
-			GLsizei length,
-			const GLchar* message,
-			const void* userParam)
-	{
-		fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
-			(type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
-			type, severity, message);
+	constexpr float PI = glm::pi<float>();
+
+	// Side by side, the first one at the origin and the rest going away from the camera.
+	// All of them turn one degree per frame at 30 fps.
+	scene_file grid(int objects, const drawable* shape) {
+		// Without a shape the objects are unit cubes.
+		const aabb bounds = shape != nullptr ? shape->bounds() : aabb{ glm::vec3(-1), glm::vec3(1) };
+		const glm::vec3 size = bounds.max - bounds.min;
+		const float spacing = 1.5f * std::max(size.x, std::max(size.y, size.z));
+		const int side = static_cast<int>(std::ceil(std::cbrt(static_cast<float>(objects))));
+
+		scene_file file;
+		file.objects.resize(objects);
+		for (int i = 0; i < objects; i++) {
+			const int x = i % side;
+			const int y = (i / side) % side;
+			const int z = i / (side * side);
+			auto& object = file.objects[i];
+			object.position = glm::vec3(
+				(x - (side - 1) / 2) * spacing,
+				(y - (side - 1) / 2) * spacing,
+				-z * spacing);
+			object.spin_axis = glm::vec3(0.5f, 0.75, 0);
+			object.spin_speed = 30 * 2 * PI / 360.0f;
+		}
+		file.timeline.finish(objects);
+		return file;
 	}
-#endif
+}
 
-	constexpr float PI = glm::pi<float>();
+engine::engine(const glm::mat4x4& proj, int objects, drawable* shape)
+	: engine(proj, grid(objects, shape), std::vector<drawable*>(objects, shape))
+{
 }
 
-engine::engine(const glm::mat4x4& proj)
-	: proj(proj)
-	, model(glm::mat4(1.0f))
-	, prog_id(program())
+engine::engine(const glm::mat4x4& proj, const scene_file& file, const std::vector<drawable*>& shapes)
+	: world(workers)
+	, timeline(file.timeline)
+	, proj(proj)
+	, eye(file.eye)
+	, target(file.target)
+	, prog_id(program(file.lights.empty() ? unlit_frag_source : shadows::fragment_source()))
+	, view_proj_location(glGetUniformLocation(prog_id, "ViewProj"))
+	, object_location(glGetUniformLocation(prog_id, "object"))
+	, decode_location(glGetUniformLocation(prog_id, "Decode"))
 {
 	glClearColor(0, 0, 0, 0);
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
+
+	const int objects = static_cast<int>(file.objects.size());
+	for (int i = 0; i < objects; i++) {
+		const auto& object = file.objects[i];
+		drawable* shape = i < static_cast<int>(shapes.size()) && shapes[i] != nullptr ? shapes[i] : &cube_mesh;
+		const int id = this->objects.add(object.position, object.rotation, object.scale);
+		if (object.spin_speed != 0) {
+			this->objects.set_spin(id, object.spin_axis, object.spin_speed);
+			spinning = true;
+		}
+		// Only a placeholder for the first BVH build, update() writes the real transform.
+		world.add(shape, shape->bounds(), glm::translate(glm::mat4(1.0f), object.position));
+	}
+
+	lods.assign(objects, 0);
+
+	// Objects with a spin or keys are never cached in the shadow maps.
+	std::vector<char> moving(file.objects.size());
+	for (int i = 0; i < objects; i++) {
+		moving[i] = file.objects[i].spin_speed != 0 || timeline.animated(i);
+		if (moving[i]) {
+			moving_ids.push_back(i);
+		}
+	}
+	// The lit program draws black without its maps, so the scene falls back to vertex colors.
+	if (!file.lights.empty() && !lighting.init(file, proj, prog_id, moving)) {
+		std::cerr << "Cannot create the shadow maps, drawing the scene unlit" << std::endl;
+		glDeleteProgram(prog_id);
+		prog_id = program(unlit_frag_source);
+		view_proj_location = glGetUniformLocation(prog_id, "ViewProj");
+		object_location = glGetUniformLocation(prog_id, "object");
+		decode_location = glGetUniformLocation(prog_id, "Decode");
+	}
+
+	GLint alignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	region_size = static_cast<GLsizeiptr>(objects * sizeof(glm::mat4));
+	region_size = (region_size + alignment - 1) / alignment * alignment;
+
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &matrix_buffer);
+	glNamedBufferStorage(matrix_buffer, region_size * matrix_regions, nullptr, flags);
+	matrices = static_cast<glm::mat4*>(glMapNamedBufferRange(matrix_buffer, 0, region_size * matrix_regions, flags));
+}
+
+engine::~engine()
+{
+	for (auto& fence : region_fence) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+	glUnmapNamedBuffer(matrix_buffer);
+	glDeleteBuffers(1, &matrix_buffer);
+	glDeleteProgram(prog_id);
 }
 
 void engine::update(double time)
 {
-	float dt = static_cast<float>(time) - static_cast<float>(last_time);
+	// Only spins and keys between their first and last key move anything, so a static
+	// scene or one whose keys have run out is not drawn again.
+	const bool first = first_update;
+	dirty = first_update || settings_changed
+		|| (time != last_time && (spinning || timeline.changes(last_time, time)));
+	// Cascades sample the camera at times of their own, which trail the frame.
+	for (int c = 0; c < lighting.cascades() && lighting.enabled() && !dirty; c++) {
+		dirty = timeline.changes(lighting.fit_time(c, last_time), lighting.fit_time(c, time));
+	}
+	first_update = false;
+	settings_changed = false;
 	last_time = time;
-	model = glm::rotate(model, 2 * PI / 360.0f, glm::vec3(0.5f, 0.75, 0));
+
+	if (!dirty) {
+		return;
+	}
+
+	// Wait until the GPU is done with the region from matrix_regions frames ago.
+	region = (region + 1) % matrix_regions;
+	if (region_fence[region] != nullptr) {
+		glClientWaitSync(region_fence[region], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(region_fence[region]);
+		region_fence[region] = nullptr;
+	}
+
+	// Cascades further out follow the camera on their own schedule, see shadows.
+	for (int c = 0; c < lighting.cascades() && lighting.enabled(); c++) {
+		glm::vec3 at_eye = eye;
+		glm::vec3 at_target = target;
+		timeline.sample_camera(lighting.fit_time(c, time), at_eye, at_target);
+		lighting.fit(c, glm::lookAt(at_eye, at_target, glm::vec3(0, 1, 0)));
+	}
+	timeline.sample_camera(time, eye, target);
+
+	auto* gpu = reinterpret_cast<glm::mat4*>(reinterpret_cast<char*>(matrices) + region * region_size);
+	auto* cpu = world.transform_data();
+	workers.parallel_for(objects.size(), 1024, [&](int begin, int end) {
+		timeline.sample(time, begin, end, objects);
+		objects.evaluate(time, begin, end, cpu);
+		std::copy(cpu + begin, cpu + end, gpu + begin);
+	});
+
+	// Static objects keep the bounds of their first update.
+	if (first) {
+		world.moved_all();
+	}
+	else {
+		world.mark_moved(moving_ids);
+	}
+	world.update();
 }
 
-void engine::render()
+void engine::render(bool clear_color)
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClear(clear_color ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_DEPTH_BUFFER_BIT);
 	glUseProgram(prog_id);
+	if (lighting.enabled()) {
+		lighting.bind(eye);
+	}
 
 	// Camera matrix
 	const glm::mat4 View = glm::lookAt(
-		glm::vec3(0, 0, 3.5f), // Camera is at (4,3,3), in World Space
-		glm::vec3(0, 0, 0), // and looks at the origin
+		eye, // Camera position in World Space
+		target, // and where it looks
 		glm::vec3(0, 1, 0)  // Head is up (set to 0,-1,0 to look upside-down)
-	);	
-	glm::mat4 mvp = proj * View * model; // Remember, matrix multiplication is the other way around
-	GLuint MatrixID = glGetUniformLocation(prog_id, "MVP");
-	glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &mvp[0][0]);
+	);
+	const glm::mat4 view_proj = proj * View; // Remember, matrix multiplication is the other way around
+	glUniformMatrix4fv(view_proj_location, 1, GL_FALSE, &view_proj[0][0]);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, matrix_buffer, region * region_size, region_size);
+
+	world.cull(view_proj, draw_list);
+	lod_counters = lod_stats();
+	const drawable* decoded = nullptr;
+	for (int id : draw_list) {
+		auto& mesh = world.mesh(id);
+		if (&mesh != decoded) {
+			const glm::mat4 decode = mesh.decode();
+			glUniformMatrix4fv(decode_location, 1, GL_FALSE, &decode[0][0]);
+			decoded = &mesh;
+		}
+
+		const int lod = select_lod(id, eye);
+		lod_counters.triangles += mesh.triangles(lod);
+		lod_counters.full_triangles += mesh.triangles(0);
 
-	cube_mesh.draw();
+		glUniform1i(object_location, id);
+		mesh.draw(lod);
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	if (lighting.enabled()) {
+		lighting.unbind();
+	}
 	glUseProgram(0);
+
+	if (region_fence[region] != nullptr) {
+		glDeleteSync(region_fence[region]);
+	}
+	region_fence[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void engine::render_shadows()
+{
+	if (!lighting.enabled()) {
+		return;
+	}
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, matrix_buffer, region * region_size, region_size);
+	lighting.render(world, lods);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+}
+
+void engine::set_lod(float pixels, int viewport_height)
+{
+	lod_pixels = pixels;
+	// Pixels covered by one unit at distance one, proj[1][1] is 1 / tan(fov / 2).
+	pixels_per_unit = viewport_height * 0.5f * proj[1][1];
+	settings_changed = true;
+}
+
+int engine::select_lod(int id, const glm::vec3& eye)
+{
+	const auto& mesh = world.mesh(id);
+	if (lod_pixels <= 0 || mesh.lods() == 1) {
+		return 0;
+	}
+
+	// Mesh space radius and errors grow with the largest axis scale of the object.
+	const glm::mat4& m = world.transform(id);
+	const float world_scale = std::max({ glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])) });
+
+	// Distance to the nearest point of the bounding sphere, so nothing is coarsened while the camera is inside it.
+	const aabb bounds = mesh.bounds();
+	const glm::vec3 center = glm::vec3(m * glm::vec4(bounds.center(), 1));
+	const float distance = std::max(glm::length(center - eye) - glm::length(bounds.extent()) * world_scale, 1e-3f);
+	const float scale = pixels_per_unit * world_scale / distance;
+
+	// Refine as soon as the current level is off by more than the threshold but
+	// only coarsen once the next level is well below it, so objects near the
+	// boundary do not switch back and forth.
+	int lod = lods[id];
+	while (lod > 0 && mesh.lod_error(lod) * scale > lod_pixels) {
+		lod--;
+	}
+	while (lod + 1 < mesh.lods() && mesh.lod_error(lod + 1) * scale < lod_pixels * (1.0f - lod_hysteresis)) {
+		lod++;
+	}
+
+	if (lod != lods[id]) {
+		lod_counters.switches++;
+		lods[id] = static_cast<uint8_t>(lod);
+	}
+	return lod;
 }
@@ -1,22 +1,100 @@
 #pragma once
 
 #include "cube.h"
+#include "jobs.h"
+#include "animation.h"
+#include "scene.h"
+#include "scenefile.h"
+#include "shadows.h"
+#include "transforms.h"
 
 #include <GL/glew.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
+#include <vector>
+
 class engine
 {
 public:
-	engine(const glm::mat4x4 &proj);
+	// More than one object lays out a grid of copies behind the first one.
+	// Without a shape the objects are cubes.
+	engine(const glm::mat4x4 &proj, int objects = 1, drawable* shape = nullptr);
+	// Objects, camera and animation from a scene file, one shape per object, null for the cube.
+	engine(const glm::mat4x4 &proj, const scene_file& file, const std::vector<drawable*>& shapes);
+	virtual ~engine();
+
+	// Evaluates every object at the absolute time, in parallel and without allocating.
 	void update(double time);
-	void render();
+	// Without clear_color the objects are drawn over what the target already holds, e.g. video.
+	void render(bool clear_color = true);
+	// Shadow maps of the lights, before render() and outside its target.
+	void render_shadows();
+
+	// Draws each object at the coarsest level of detail whose error projects to
+	// at most this many pixels, 0 always draws the full geometry.
+	void set_lod(float pixels, int viewport_height);
+	// Frames per second of the video, the shadow cascades are refit on a schedule of frames.
+	void set_frame_rate(int fps) { lighting.set_frame_rate(fps); settings_changed = true; }
+
+	struct lod_stats {
+		int64_t triangles = 0;		// drawn last frame
+		int64_t full_triangles = 0;	// the same objects at full detail
+		int switches = 0;			// objects that changed level
+	};
+	[[nodiscard]] const lod_stats& get_lod_stats() const { return lod_counters; }
+
+	[[nodiscard]] const scene::cull_stats& get_cull_stats() const { return world.get_stats(); }
+	[[nodiscard]] const shadows::stats& get_shadow_stats() const { return lighting.get_stats(); }
+
+	// True if the last update changed anything that ends up in the frame.
+	[[nodiscard]] bool changed() const { return dirty; }
+	[[nodiscard]] int object_count() const { return objects.size(); }
+	// True if the scene has lights, render_shadows() has to run before render() then.
+	[[nodiscard]] bool lit() const { return lighting.enabled(); }
 
 private:
+	// Model matrices are written by the update jobs straight into a persistently
+	// mapped buffer with one region per frame in flight, fenced before reuse.
+	enum constants {
+		matrix_regions = 3
+	};
+
+	// Fraction below the pixel threshold the next coarser level has to reach.
+	static constexpr float lod_hysteresis = 0.25f;
+
+	int select_lod(int id, const glm::vec3& eye);
+
 	cube cube_mesh;
+	jobs workers;
+	scene world;
+	transforms objects;
+	animation timeline;
+	shadows lighting;
+	// Objects with a spin or keys, the only ones refit in the BVH after the first update.
+	std::vector<int> moving_ids;
+	std::vector<int> draw_list;
 	glm::mat4x4 proj;
-	glm::mat4x4 model;
+	glm::vec3 eye;
+	glm::vec3 target;
 	double last_time = 0;
+	bool dirty = true;
+	bool first_update = true;
+	bool settings_changed = false;	// by set_lod or set_frame_rate since the last update
+	bool spinning = false;			// any object has a spin
 	GLuint prog_id;
+	GLint view_proj_location;
+	GLint object_location;
+	GLint decode_location;
+	GLuint matrix_buffer = 0;
+	glm::mat4* matrices = nullptr;
+	GLsizeiptr region_size = 0;
+	int region = 0;
+	GLsync region_fence[matrix_regions]{};
+
+	std::vector<uint8_t> lods;
+	float lod_pixels = 0;
+	float pixels_per_unit = 0;
+	lod_stats lod_counters;
 };
 
@@ -0,0 +1,295 @@
+#include "framegraph.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+	// Framebuffer writes are ordered with later commands by GL itself, only
+	// incoherent image stores need an explicit barrier before they are consumed.
+	GLbitfield barrier_for(framegraph::access written, framegraph::access read) {
+		if (written != framegraph::access::image) {
+			return 0;
+		}
+
+		switch (read) {
+		case framegraph::access::attachment:
+			return GL_FRAMEBUFFER_BARRIER_BIT;
+		case framegraph::access::sampled:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case framegraph::access::image:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case framegraph::access::readback:
+		case framegraph::access::transfer:
+			return GL_TEXTURE_UPDATE_BARRIER_BIT;
+		}
+		return 0;
+	}
+}
+
+RenderTarget& framegraph::registry::target(resource id) const
+{
+	return *graph.targets[graph.resources[id].physical];
+}
+
+GLuint framegraph::registry::texture(resource id) const
+{
+	const auto& res = graph.resources[id];
+	return res.transient ? graph.targets[res.physical]->get_texture() : res.texture;
+}
+
+framegraph::resource framegraph::create_target(const std::string& name, GLsizei width, GLsizei height)
+{
+	resource_node res;
+	res.name = name;
+	res.width = width;
+	res.height = height;
+	res.transient = true;
+	resources.push_back(res);
+	compiled = false;
+	return static_cast<resource>(resources.size() - 1);
+}
+
+framegraph::resource framegraph::import(const std::string& name, GLuint texture)
+{
+	resource_node res;
+	res.name = name;
+	res.texture = texture;
+	resources.push_back(res);
+	compiled = false;
+	return static_cast<resource>(resources.size() - 1);
+}
+
+void framegraph::mark_output(resource id)
+{
+	resources[id].output = true;
+	compiled = false;
+}
+
+void framegraph::add_pass(const std::string& name, std::vector<use> reads, std::vector<use> writes,
+	execute_fn execute, bool side_effect)
+{
+	pass_node pass;
+	pass.name = name;
+	pass.reads = std::move(reads);
+	pass.writes = std::move(writes);
+	pass.execute = std::move(execute);
+	pass.side_effect = side_effect;
+	passes.push_back(std::move(pass));
+	compiled = false;
+}
+
+bool framegraph::compile()
+{
+	const int pass_count = static_cast<int>(passes.size());
+	counters = stats();
+	counters.passes = pass_count;
+
+	for (auto& res : resources) {
+		res.writer = -1;
+		res.physical = -1;
+	}
+
+	// Every resource has at most one producer per frame, which makes the
+	// dependencies between passes unambiguous.
+	for (int p = 0; p < pass_count; p++) {
+		for (const auto& w : passes[p].writes) {
+			auto& res = resources[w.id];
+			if (res.writer >= 0) {
+				std::cerr << "Frame graph: " << res.name << " written by both "
+					<< passes[res.writer].name << " and " << passes[p].name << std::endl;
+				return false;
+			}
+			res.writer = p;
+		}
+	}
+
+	// Order passes so that producers run before consumers, ties are broken by
+	// declaration order so the schedule is stable from frame to frame.
+	std::vector<std::vector<int>> consumers(pass_count);
+	std::vector<int> pending(pass_count, 0);
+	for (int p = 0; p < pass_count; p++) {
+		for (const auto& r : passes[p].reads) {
+			const auto& res = resources[r.id];
+			if (res.writer < 0) {
+				if (res.transient) {
+					std::cerr << "Frame graph: " << passes[p].name << " reads "
+						<< res.name << " which is never written" << std::endl;
+					return false;
+				}
+				continue;
+			}
+			consumers[res.writer].push_back(p);
+			pending[p]++;
+		}
+	}
+
+	order.clear();
+	std::vector<int> ready;
+	for (int p = 0; p < pass_count; p++) {
+		if (pending[p] == 0) {
+			ready.push_back(p);
+		}
+	}
+
+	while (!ready.empty()) {
+		auto next = std::min_element(ready.begin(), ready.end());
+		const int p = *next;
+		ready.erase(next);
+		order.push_back(p);
+		for (int c : consumers[p]) {
+			if (--pending[c] == 0) {
+				ready.push_back(c);
+			}
+		}
+	}
+
+	if (static_cast<int>(order.size()) != pass_count) {
+		std::cerr << "Frame graph: cycle between passes" << std::endl;
+		return false;
+	}
+
+	// Cull from the back: a pass survives if it has side effects or produces
+	// something that an output or a surviving pass depends on.
+	std::vector<bool> needed(resources.size(), false);
+	for (size_t r = 0; r < resources.size(); r++) {
+		needed[r] = resources[r].output;
+	}
+
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		auto& pass = passes[*it];
+		pass.culled = !pass.side_effect && std::none_of(pass.writes.begin(), pass.writes.end(),
+			[&](const use& w) { return needed[w.id]; });
+
+		if (pass.culled) {
+			counters.culled++;
+			continue;
+		}
+
+		for (const auto& r : pass.reads) {
+			needed[r.id] = true;
+		}
+	}
+
+	order.erase(std::remove_if(order.begin(), order.end(),
+		[&](int p) { return passes[p].culled; }), order.end());
+
+	// Lifetime of each transient resource in positions of the surviving schedule.
+	std::vector<int> first_use(resources.size(), -1);
+	std::vector<int> last_use(resources.size(), -1);
+	for (int i = 0; i < static_cast<int>(order.size()); i++) {
+		const auto& pass = passes[order[i]];
+		for (const auto* uses : { &pass.reads, &pass.writes }) {
+			for (const auto& u : *uses) {
+				if (first_use[u.id] < 0) {
+					first_use[u.id] = i;
+				}
+				last_use[u.id] = i;
+			}
+		}
+	}
+
+	for (size_t r = 0; r < resources.size(); r++) {
+		if (resources[r].output) {
+			last_use[r] = static_cast<int>(order.size());
+		}
+	}
+
+	// Alias transient targets: hand out a physical target whose previous
+	// occupant is dead before the new one is born, allocate only when none is.
+	std::vector<int> by_birth;
+	for (int r = 0; r < static_cast<int>(resources.size()); r++) {
+		if (resources[r].transient && first_use[r] >= 0) {
+			by_birth.push_back(r);
+		}
+	}
+	std::sort(by_birth.begin(), by_birth.end(),
+		[&](int a, int b) { return first_use[a] < first_use[b]; });
+
+	struct slot {
+		GLsizei width;
+		GLsizei height;
+		int busy_until;
+	};
+	std::vector<slot> slots;
+
+	for (int r : by_birth) {
+		auto& res = resources[r];
+		counters.transient++;
+
+		for (int s = 0; s < static_cast<int>(slots.size()); s++) {
+			if (slots[s].width == res.width && slots[s].height == res.height
+				&& slots[s].busy_until < first_use[r]) {
+				res.physical = s;
+				break;
+			}
+		}
+
+		if (res.physical < 0) {
+			res.physical = static_cast<int>(slots.size());
+			slots.push_back({ res.width, res.height, 0 });
+		}
+		slots[res.physical].busy_until = last_use[r];
+	}
+
+	// The pool only grows, targets from an earlier compile are reused as is.
+	for (size_t s = targets.size(); s < slots.size(); s++) {
+		auto target = std::make_unique<RenderTarget>();
+		if (!target->init(slots[s].width, slots[s].height)) {
+			return false;
+		}
+		targets.push_back(std::move(target));
+	}
+	counters.physical = static_cast<int>(slots.size());
+
+	// Barriers between the last producer of a resource and each consumer.
+	for (int p : order) {
+		auto& pass = passes[p];
+		pass.barrier = 0;
+		for (const auto& r : pass.reads) {
+			const int writer = resources[r.id].writer;
+			if (writer < 0) {
+				continue;
+			}
+			for (const auto& w : passes[writer].writes) {
+				if (w.id == r.id) {
+					pass.barrier |= barrier_for(w.how, r.how);
+				}
+			}
+		}
+		if (pass.barrier != 0) {
+			counters.barriers++;
+		}
+	}
+
+	compiled = true;
+	return true;
+}
+
+void framegraph::execute()
+{
+	if (!compiled && !compile()) {
+		return;
+	}
+
+	const registry reg(*this);
+	for (int p : order) {
+		const auto& pass = passes[p];
+		if (pass.barrier != 0) {
+			glMemoryBarrier(pass.barrier);
+		}
+		pass.execute(reg);
+	}
+}
+
+void framegraph::print(std::ostream& out) const
+{
+	out << "Frame graph: " << counters.passes - counters.culled << " of " << counters.passes
+		<< " passes, " << counters.physical << " render targets for " << counters.transient
+		<< " transient, " << counters.barriers << " barriers" << std::endl;
+
+	for (int p = 0; p < static_cast<int>(passes.size()); p++) {
+		if (passes[p].culled) {
+			out << "  culled: " << passes[p].name << std::endl;
+		}
+	}
+}
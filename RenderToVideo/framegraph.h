@@ -0,0 +1,104 @@
+#pragma once
+#include "rendertarget.h"
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A small frame graph. Passes declare which resources they read and write, the graph
+// orders them by their dependencies, culls passes that do not contribute to an output,
+// lets transient render targets with disjoint lifetimes share one RenderTarget and only
+// issues the glMemoryBarrier calls that the declared accesses require.
+// https://www.gdcvault.com/play/1024612/FrameGraph-Extensible-Rendering-Architecture-in
+
+class framegraph
+{
+public:
+	using resource = int;
+
+	enum class access {
+		attachment,	// framebuffer attachment (draw)
+		sampled,	// texture fetch through a sampler
+		image,		// image load/store
+		readback,	// glGetTextureImage / pixel pack
+		transfer,	// glTextureSubImage / pixel unpack
+	};
+
+	struct use {
+		resource id;
+		access how;
+	};
+
+	class registry {
+	public:
+		[[nodiscard]] RenderTarget& target(resource id) const;
+		[[nodiscard]] GLuint texture(resource id) const;
+
+	private:
+		friend class framegraph;
+		explicit registry(const framegraph& graph) : graph(graph) {}
+		const framegraph& graph;
+	};
+
+	using execute_fn = std::function<void(const registry&)>;
+
+	struct stats {
+		int passes = 0;
+		int culled = 0;
+		int transient = 0;
+		int physical = 0;
+		int barriers = 0;
+	};
+
+	virtual ~framegraph() = default;
+
+	// Transient render target, owned and aliased by the graph.
+	resource create_target(const std::string& name, GLsizei width, GLsizei height);
+	// Persistent resource owned by someone else, e.g. the yuv planes or the window.
+	resource import(const std::string& name, GLuint texture = 0);
+	// Keep the passes producing this resource even if nothing in the graph reads it.
+	void mark_output(resource id);
+
+	// A pass with side effects (readback, file output, swap) is never culled.
+	void add_pass(const std::string& name, std::vector<use> reads, std::vector<use> writes,
+		execute_fn execute, bool side_effect = false);
+
+	[[nodiscard]] bool compile();
+	void execute();
+
+	[[nodiscard]] const stats& get_stats() const { return counters; }
+	void print(std::ostream& out) const;
+
+private:
+	struct resource_node {
+		std::string name;
+		GLsizei width = 0;
+		GLsizei height = 0;
+		GLuint texture = 0;
+		bool transient = false;
+		bool output = false;
+		int writer = -1;
+		int physical = -1;
+	};
+
+	struct pass_node {
+		std::string name;
+		std::vector<use> reads;
+		std::vector<use> writes;
+		execute_fn execute;
+		bool side_effect = false;
+		bool culled = false;
+		GLbitfield barrier = 0;
+	};
+
+	std::vector<resource_node> resources;
+	std::vector<pass_node> passes;
+	std::vector<int> order;
+	std::vector<std::unique_ptr<RenderTarget>> targets;
+	stats counters;
+	bool compiled = false;
+};
@@ -0,0 +1,215 @@
+#include "framehash.h"
+#include "glprofile.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	// 64 bit FNV-1a on pairs of 32 bit words, low word first. The prime is
+	// 2^40 + 0x1B3, so the multiply is one widening multiply plus a shift.
+	const char* fnv_source = R"(
+		const uvec2 fnv_basis = uvec2(0x84222325u, 0xCBF29CE4u);
+
+		uvec2 fnv(uvec2 h, uint byte) {
+			h.x ^= byte;
+			uint msb, lsb;
+			umulExtended(h.x, 0x1B3u, msb, lsb);
+			return uvec2(lsb, h.y * 0x1B3u + msb + (h.x << 8));
+		}
+	)";
+
+	const char* rows_source = R"(
+		layout(local_size_x = 64) in;
+
+		layout(std430, binding = 0) readonly buffer Frame { uint frame[]; };
+		layout(std430, binding = 1) writeonly buffer Rows { uvec2 row_hash[]; };
+
+		uniform int width;
+		uniform int height;
+
+		void main() {
+			int row = int(gl_GlobalInvocationID.x);
+			if (row >= height * 2) {
+				return;
+			}
+
+			// Y rows, then U rows, then V rows, as the planes follow each other.
+			int offset = row * width;
+			int length = width;
+			if (row >= height) {
+				offset = height * width + (row - height) * (width / 2);
+				length = width / 2;
+			}
+
+			uvec2 h = fnv_basis;
+			for (int i = offset; i < offset + length; i++) {
+				h = fnv(h, (frame[i >> 2] >> ((i & 3) * 8)) & 0xFFu);
+			}
+			row_hash[row] = h;
+		}
+	)";
+
+	const char* combine_source = R"(
+		layout(local_size_x = 1) in;
+
+		layout(std430, binding = 1) readonly buffer Rows { uvec2 row_hash[]; };
+		layout(std430, binding = 2) writeonly buffer Results { uvec2 result[]; };
+
+		uniform int rows;
+		uniform int slot;
+
+		void main() {
+			uvec2 h = fnv_basis;
+			for (int r = 0; r < rows; r++) {
+				for (int b = 0; b < 64; b += 8) {
+					uint word = b < 32 ? row_hash[r].x : row_hash[r].y;
+					h = fnv(h, (word >> (b & 31)) & 0xFFu);
+				}
+			}
+			result[slot] = h;
+		}
+	)";
+
+	GLuint compute_program(const char* body) {
+		const char* sources[] = { "#version 430 core\n", fnv_source, body };
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 3, sources, nullptr);
+		glCompileShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			GLchar log[512]{};
+			glGetShaderInfoLog(shader, sizeof(log) - 1, nullptr, log);
+			std::cerr << "Frame hash shader: " << log << std::endl;
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		GLuint prog = glCreateProgram();
+		glAttachShader(prog, shader);
+		glLinkProgram(prog);
+		glDeleteShader(shader);
+
+		glGetProgramiv(prog, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE) {
+			std::cerr << "Frame hash shader: link error" << std::endl;
+			glDeleteProgram(prog);
+			return 0;
+		}
+		return prog;
+	}
+}
+
+frame_hash::~frame_hash()
+{
+	Free();
+}
+
+bool frame_hash::init(GLsizei width, GLsizei height, int slots)
+{
+	if (rows_program > 0) {
+		return false;
+	}
+	// The shader reads the frame as whole words and the buffer holds exactly one frame.
+	if (width % 2 != 0 || height % 2 != 0 || static_cast<int64_t>(width) * height % 8 != 0) {
+		std::cerr << "Frame hash: " << width << "x" << height << " I420 frames are not a whole number of words" << std::endl;
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	rows_program = compute_program(rows_source);
+	combine_program = compute_program(combine_source);
+	if (rows_program == 0 || combine_program == 0) {
+		Free();
+		return false;
+	}
+
+	glCreateBuffers(1, &row_buffer);
+	glNamedBufferStorage(row_buffer, static_cast<GLsizeiptr>(height) * 2 * sizeof(uint64_t), nullptr, 0);
+
+	constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &result_buffer);
+	glNamedBufferStorage(result_buffer, slots * sizeof(uint64_t), nullptr, flags);
+	results = static_cast<const uint64_t*>(glMapNamedBufferRange(result_buffer, 0, slots * sizeof(uint64_t), flags));
+	return results != nullptr;
+}
+
+void frame_hash::dispatch(GLuint buffer, int slot)
+{
+	const GLsizeiptr frame_size = static_cast<GLsizeiptr>(width) * height * 3 / 2;
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, buffer, 0, frame_size);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, row_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, result_buffer);
+
+	// The previous frame's combine pass reads the rows this one overwrites.
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glUseProgram(rows_program);
+	glUniform1i(glGetUniformLocation(rows_program, "width"), width);
+	glUniform1i(glGetUniformLocation(rows_program, "height"), height);
+	glDispatchCompute((height * 2 + 63) / 64, 1, 1);
+
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glUseProgram(combine_program);
+	glUniform1i(glGetUniformLocation(combine_program, "rows"), height * 2);
+	glUniform1i(glGetUniformLocation(combine_program, "slot"), slot);
+	glDispatchCompute(1, 1, 1);
+
+	// Visible through the mapping once the fence that follows has signaled.
+	glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+	glUseProgram(0);
+}
+
+void frame_hash::Free()
+{
+	if (results != nullptr) {
+		glUnmapNamedBuffer(result_buffer);
+		results = nullptr;
+	}
+	glDeleteBuffers(1, &row_buffer);
+	glDeleteBuffers(1, &result_buffer);
+	glDeleteProgram(rows_program);
+	glDeleteProgram(combine_program);
+	row_buffer = 0;
+	result_buffer = 0;
+	rows_program = 0;
+	combine_program = 0;
+}
+
+void write_manifest_header(std::ostream& out, int width, int height)
+{
+	out << "# RenderToVideo frame hashes, " << width << "x" << height << " I420, FNV-1a 64 of row hashes" << std::endl;
+}
+
+void write_manifest_entry(std::ostream& out, int frame, uint64_t hash)
+{
+	out << frame << " " << std::hex << hash << std::dec << "\n";
+}
+
+bool load_manifest(const std::string& path, std::unordered_map<int, uint64_t>& hashes)
+{
+	std::ifstream in(path);
+	if (!in) {
+		std::cerr << "Cannot open " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	for (int line_no = 1; std::getline(in, line); line_no++) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream fields(line);
+		int frame = 0;
+		uint64_t hash = 0;
+		if (!(fields >> frame >> std::hex >> hash)) {
+			std::cerr << path << ":" << line_no << ": expected <frame> <hash>" << std::endl;
+			return false;
+		}
+		hashes[frame] = hash;
+	}
+	return true;
+}
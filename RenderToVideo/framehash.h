@@ -0,0 +1,46 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Hashes of I420 frames computed by compute shaders from the buffer the readback
+// copies the planes into, so a render can be verified frame by frame without moving
+// the frames. One invocation per row runs 64 bit FNV-1a over the bytes of the row,
+// a second pass runs it over the row hashes; hash_planes() in golden.h computes the
+// same on the CPU. Results land in a persistently mapped buffer, one entry per slot,
+// and are valid once the fence after dispatch() has signaled.
+
+class frame_hash
+{
+public:
+	virtual ~frame_hash();
+
+	// Frames have to be a multiple of 4 bytes, width * height a multiple of 8.
+	[[nodiscard]] bool init(GLsizei width, GLsizei height, int slots);
+
+	// Queues the hash of the tightly packed I420 frame in buffer into slot.
+	void dispatch(GLuint buffer, int slot);
+	[[nodiscard]] uint64_t result(int slot) const { return results[slot]; }
+
+private:
+	void Free();
+
+private:
+	GLsizei width = 0;
+	GLsizei height = 0;
+	GLuint rows_program = 0;
+	GLuint combine_program = 0;
+	GLuint row_buffer = 0;
+	GLuint result_buffer = 0;
+	const uint64_t* results = nullptr;
+};
+
+// Sidecar of a render: a comment line, then "<frame> <hash>" per frame, hash in hex.
+void write_manifest_header(std::ostream& out, int width, int height);
+void write_manifest_entry(std::ostream& out, int frame, uint64_t hash);
+[[nodiscard]] bool load_manifest(const std::string& path, std::unordered_map<int, uint64_t>& hashes);
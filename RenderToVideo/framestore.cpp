@@ -0,0 +1,258 @@
+#include "framestore.h"
+#include "golden.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// Default index size when the frame count is not known, an hour at 30 fps.
+	constexpr uint32_t default_capacity = 30 * 60 * 60;
+	// Frames the file grows by when it was not preallocated.
+	constexpr uint64_t grow_frames = 64;
+
+	constexpr uint64_t page = 4096;
+}
+
+frame_store::~frame_store()
+{
+	Free();
+}
+
+bool frame_store::init(const std::string& path, int width, int height, int fps, int first_frame, int capacity)
+{
+	if (view != nullptr) {
+		return false;
+	}
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+	}
+	const bool opened = file != nullptr;
+#else
+	fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	const bool opened = fd >= 0;
+#endif
+	if (!opened) {
+		std::cerr << "Cannot create " << path << std::endl;
+		return false;
+	}
+
+	frame_store_format::header h{};
+	h.magic = frame_store_format::magic;
+	h.version = frame_store_format::version;
+	h.width = width;
+	h.height = height;
+	h.fps = fps;
+	h.first_frame = first_frame;
+	h.capacity = capacity > 0 ? capacity : default_capacity;
+	h.frame_size = static_cast<uint64_t>(width) * height * 3 / 2;
+	const uint64_t index_end = sizeof(h) + h.capacity * sizeof(frame_store_format::entry);
+	h.data_offset = (index_end + page - 1) / page * page;
+
+	const uint64_t preallocated = capacity > 0 ? h.capacity : std::min<uint64_t>(grow_frames, h.capacity);
+	if (!resize(h.data_offset + preallocated * h.frame_size)) {
+		std::cerr << "Cannot allocate " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	*head() = h;
+	return true;
+}
+
+bool frame_store::init(const std::string& path)
+{
+	if (view != nullptr) {
+		return false;
+	}
+
+	uint64_t size = 0;
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+	}
+	LARGE_INTEGER file_size{};
+	const bool opened = file != nullptr && GetFileSizeEx(file, &file_size);
+	size = static_cast<uint64_t>(file_size.QuadPart);
+#else
+	fd = open(path.c_str(), O_RDWR);
+	struct stat info {};
+	const bool opened = fd >= 0 && fstat(fd, &info) == 0;
+	size = static_cast<uint64_t>(info.st_size);
+#endif
+	if (!opened) {
+		std::cerr << "Cannot open " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	if (size < sizeof(frame_store_format::header) || !resize(size)) {
+		std::cerr << "Cannot map " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	auto* h = head();
+	const uint64_t index_end = sizeof(*h) + static_cast<uint64_t>(h->capacity) * sizeof(frame_store_format::entry);
+	if (h->magic != frame_store_format::magic || h->version != frame_store_format::version
+		|| h->frame_size != static_cast<uint64_t>(h->width) * h->height * 3 / 2
+		|| h->data_offset < index_end || h->data_offset > size || h->count > h->capacity) {
+		std::cerr << "Not a frame store: " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	// A frame whose data or checksum did not make it to disk ends the store.
+	const uint64_t stored = std::min<uint64_t>(h->count, (size - h->data_offset) / h->frame_size);
+	uint32_t valid = 0;
+	while (valid < stored && hash_frame(frame(valid), frame_size()) == index()[valid].checksum) {
+		valid++;
+	}
+	if (valid < h->count) {
+		std::cerr << "Frame store " << path << ": keeping " << valid << " of " << h->count << " frames" << std::endl;
+	}
+	h->count = valid;
+	return true;
+}
+
+bool frame_store::write(const unsigned char* data, size_t size)
+{
+	auto* h = head();
+	if (size != h->frame_size) {
+		return false;
+	}
+	if (h->count == h->capacity) {
+		std::cerr << "Frame store is full after " << h->count << " frames" << std::endl;
+		return false;
+	}
+
+	const uint64_t end = h->data_offset + (h->count + 1ull) * h->frame_size;
+	if (end > length) {
+		const uint64_t frames = std::min<uint64_t>(h->count + grow_frames, h->capacity);
+		if (!resize(h->data_offset + frames * h->frame_size)) {
+			std::cerr << "Cannot grow the frame store" << std::endl;
+			return false;
+		}
+		h = head();
+	}
+
+	// Data first, then its checksum, then the count: a frame interrupted halfway
+	// either is not counted or fails its checksum when the store is opened again.
+	std::memcpy(view + h->data_offset + h->count * h->frame_size, data, size);
+	index()[h->count].checksum = hash_frame(data, size);
+	h->count++;
+	return true;
+}
+
+#ifdef _WIN32
+
+bool frame_store::resize(uint64_t size)
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+		CloseHandle(mapping);
+		view = nullptr;
+		mapping = nullptr;
+	}
+
+	LARGE_INTEGER end{};
+	end.QuadPart = static_cast<LONGLONG>(size);
+	if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+	if (mapping != nullptr) {
+		view = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+	}
+	length = view != nullptr ? size : 0;
+	return view != nullptr;
+}
+
+void frame_store::Free()
+{
+	// Frames that were never written are not kept.
+	const uint64_t used = view != nullptr ? head()->data_offset + head()->count * head()->frame_size : 0;
+	if (view != nullptr) {
+		FlushViewOfFile(view, 0);
+		UnmapViewOfFile(view);
+	}
+	if (mapping != nullptr) {
+		CloseHandle(mapping);
+	}
+	if (file != nullptr) {
+		if (used > 0) {
+			LARGE_INTEGER end{};
+			end.QuadPart = static_cast<LONGLONG>(used);
+			SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+			SetEndOfFile(file);
+		}
+		CloseHandle(file);
+	}
+	view = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	length = 0;
+}
+
+#else
+
+bool frame_store::resize(uint64_t size)
+{
+	if (view != nullptr) {
+		munmap(view, length);
+		view = nullptr;
+		length = 0;
+	}
+
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		return false;
+	}
+
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		return false;
+	}
+
+	view = static_cast<unsigned char*>(address);
+	length = size;
+	return true;
+}
+
+void frame_store::Free()
+{
+	// Frames that were never written are not kept.
+	const uint64_t used = view != nullptr ? head()->data_offset + head()->count * head()->frame_size : 0;
+	if (view != nullptr) {
+		msync(view, length, MS_SYNC);
+		munmap(view, length);
+	}
+	if (fd >= 0) {
+		if (used > 0 && ftruncate(fd, static_cast<off_t>(used)) != 0) {
+			std::cerr << "Cannot trim the frame store" << std::endl;
+		}
+		close(fd);
+	}
+	view = nullptr;
+	fd = -1;
+	length = 0;
+}
+
+#endif
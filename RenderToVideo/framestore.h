@@ -0,0 +1,73 @@
+#pragma once
+#include "sink.h"
+
+#include <cstdint>
+#include <string>
+
+// Raw I420 frames in a memory mapped file, written as they are rendered so that an
+// interrupted render keeps its frames: it resumes after the last complete one, and
+// the frames can be encoded again without rendering them.
+//
+// Layout: header, an index with a checksum per frame, then the frames back to back
+// from a page aligned offset, so ffmpeg can also read them as rawvideo with
+// -skip_initial_bytes. The file is preallocated when the frame count is known and
+// grows in chunks otherwise.
+
+namespace frame_store_format {
+	constexpr uint32_t magic = 0x31534652;	// "RFS1"
+	constexpr uint32_t version = 1;
+
+	struct header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t fps;
+		uint32_t first_frame;	// timeline position of frame 0
+		uint32_t capacity;		// index entries
+		uint32_t count;			// complete frames
+		uint64_t frame_size;
+		uint64_t data_offset;
+	};
+	static_assert(sizeof(header) == 48, "frame store header layout");
+
+	struct entry {
+		uint64_t checksum;		// hash_frame of the frame
+	};
+}
+
+class frame_store : public sink
+{
+public:
+	~frame_store() override;
+
+	// A new store for up to capacity frames, 0 if unknown.
+	[[nodiscard]] bool init(const std::string& path, int width, int height, int fps, int first_frame, int capacity);
+	// An existing store, cut back to the frames before the first one with a wrong checksum.
+	[[nodiscard]] bool init(const std::string& path);
+
+	// Appends one frame of exactly frame_size() bytes.
+	bool write(const unsigned char* data, size_t size) override;
+
+	[[nodiscard]] const frame_store_format::header& info() const { return *head(); }
+	[[nodiscard]] int frames() const { return static_cast<int>(head()->count); }
+	[[nodiscard]] size_t frame_size() const { return static_cast<size_t>(head()->frame_size); }
+	[[nodiscard]] const unsigned char* frame(int i) const { return view + head()->data_offset + i * frame_size(); }
+
+private:
+	[[nodiscard]] frame_store_format::header* head() const { return reinterpret_cast<frame_store_format::header*>(view); }
+	[[nodiscard]] frame_store_format::entry* index() const { return reinterpret_cast<frame_store_format::entry*>(view + sizeof(frame_store_format::header)); }
+	// Sets the file size and maps all of it again.
+	bool resize(uint64_t size);
+	void Free();
+
+private:
+	unsigned char* view = nullptr;
+	uint64_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
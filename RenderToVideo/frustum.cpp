@@ -0,0 +1,140 @@
+#include "frustum.h"
+
+#ifdef RENDER_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RENDER_TARGET_AVX2
+#else
+#define RENDER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+	bool cpu_has_avx2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		// AVX, and the OS saves the YMM registers.
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	// Only this function is compiled for AVX2, it is called after the check above and
+	// only reads through plain pointers, so no AVX2 copy of shared inline code is made.
+	// Tests boxes [i, end) eight at a time and returns where it stopped.
+	RENDER_TARGET_AVX2 int cull_avx2(const glm::vec4* planes, const float* const bounds[6],
+		int i, int end, int* out, int& visible) {
+		for (; i + 8 <= end; i += 8) {
+			__m256 outside = _mm256_setzero_ps();
+			for (int plane = 0; plane < 6; plane++) {
+				const auto& p = planes[plane];
+				const float* x = bounds[p.x >= 0 ? 3 : 0] + i;
+				const float* y = bounds[p.y >= 0 ? 4 : 1] + i;
+				const float* z = bounds[p.z >= 0 ? 5 : 2] + i;
+
+				__m256 d = _mm256_set1_ps(p.w);
+				d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.x), _mm256_loadu_ps(x)));
+				d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.y), _mm256_loadu_ps(y)));
+				d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.z), _mm256_loadu_ps(z)));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			const int mask = _mm256_movemask_ps(outside);
+			for (int bit = 0; bit < 8; bit++) {
+				if ((mask & (1 << bit)) == 0) {
+					out[visible++] = i + bit;
+				}
+			}
+		}
+		return i;
+	}
+}
+#endif
+
+frustum::frustum(const glm::mat4& view_proj)
+{
+	// Rows of the matrix, glm is column major.
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++) {
+		row[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+	}
+
+	planes[0] = row[3] + row[0];	// left
+	planes[1] = row[3] - row[0];	// right
+	planes[2] = row[3] + row[1];	// bottom
+	planes[3] = row[3] - row[1];	// top
+	planes[4] = row[3] + row[2];	// near
+	planes[5] = row[3] - row[2];	// far
+
+	for (auto& p : planes) {
+		p = p / glm::length(glm::vec3(p.x, p.y, p.z));
+	}
+}
+
+frustum::result frustum::test(const aabb& box) const
+{
+	result res = result::inside;
+	for (const auto& p : planes) {
+		// The corner furthest along the normal decides if the box is outside,
+		// the nearest one if it straddles the plane.
+		const glm::vec3 far_corner(p.x >= 0 ? box.max.x : box.min.x,
+			p.y >= 0 ? box.max.y : box.min.y,
+			p.z >= 0 ? box.max.z : box.min.z);
+		if (p.x * far_corner.x + p.y * far_corner.y + p.z * far_corner.z + p.w < 0) {
+			return result::outside;
+		}
+
+		const glm::vec3 near_corner(p.x >= 0 ? box.min.x : box.max.x,
+			p.y >= 0 ? box.min.y : box.max.y,
+			p.z >= 0 ? box.min.z : box.max.z);
+		if (p.x * near_corner.x + p.y * near_corner.y + p.z * near_corner.z + p.w < 0) {
+			res = result::intersects;
+		}
+	}
+	return res;
+}
+
+int frustum::cull(const aabb_soa& boxes, int first, int count, int* out) const
+{
+	int visible = 0;
+	int i = first;
+	const int end = first + count;
+
+#ifdef RENDER_AVX2
+	static const bool avx2 = cpu_has_avx2();
+	if (avx2) {
+		const float* const bounds[6] = { boxes.min_x.data(), boxes.min_y.data(), boxes.min_z.data(),
+			boxes.max_x.data(), boxes.max_y.data(), boxes.max_z.data() };
+		i = cull_avx2(planes, bounds, i, end, out, visible);
+	}
+#endif
+
+	for (; i < end; i++) {
+		bool inside = true;
+		for (const auto& p : planes) {
+			const float x = p.x >= 0 ? boxes.max_x[i] : boxes.min_x[i];
+			const float y = p.y >= 0 ? boxes.max_y[i] : boxes.min_y[i];
+			const float z = p.z >= 0 ? boxes.max_z[i] : boxes.min_z[i];
+			if (p.x * x + p.y * y + p.z * z + p.w < 0) {
+				inside = false;
+				break;
+			}
+		}
+		if (inside) {
+			out[visible++] = i;
+		}
+	}
+
+	return visible;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "bounds.h"
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward facing planes, extracted from a view-projection matrix.
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+
+class frustum
+{
+public:
+	explicit frustum(const glm::mat4& view_proj);
+
+	enum class result {
+		outside,
+		intersects,
+		inside,
+	};
+
+	[[nodiscard]] result test(const aabb& box) const;
+
+	// Tests boxes [first, first + count) and appends the indices of the visible ones to out.
+	// Uses AVX2 for eight boxes at a time when built with RENDER_AVX2 and the CPU has it.
+	// Returns the number appended.
+	int cull(const aabb_soa& boxes, int first, int count, int* out) const;
+
+private:
+	glm::vec4 planes[6];
+};
@@ -0,0 +1,505 @@
+#define GL_PROFILE_IMPLEMENTATION
+#include "glprofile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <unordered_map>
+
+namespace {
+	void GLAPIENTRY
+		MessageCallback(GLenum source,
+			GLenum type,
+			GLuint id,
+			GLenum severity,
+			GLsizei length,
+			const GLchar* message,
+			const void* userParam)
+	{
+#ifndef _DEBUG
+		if (type != GL_DEBUG_TYPE_ERROR && severity != GL_DEBUG_SEVERITY_HIGH) {
+			return;
+		}
+#endif
+		fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
+			(type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
+			type, severity, message);
+	}
+}
+
+void enable_debug_output()
+{
+	if (!GLEW_KHR_debug && !GLEW_VERSION_4_3) {
+		return;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(MessageCallback, nullptr);
+	// Notifications are sent for every buffer placement and would drown everything else.
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+}
+
+#ifdef RENDER_GL_PROFILE
+
+namespace gl_profile {
+	namespace {
+		counters current;
+		counters total;
+		counters largest;
+		int64_t frames = 0;
+
+		// What is bound, per binding point, to spot binds that change nothing.
+		enum class point : uint64_t { buffer, buffer_index, framebuffer, renderbuffer, texture, texture_unit, vertex_array, program };
+		std::unordered_map<uint64_t, uint64_t> bound;
+		GLuint active_unit = 0;
+
+		void count(kind k) {
+			current.calls[static_cast<int>(k)]++;
+		}
+
+		void bind(point p, uint64_t target, uint64_t object) {
+			count(kind::bind);
+			const uint64_t key = static_cast<uint64_t>(p) << 56 ^ target;
+			auto [it, inserted] = bound.try_emplace(key, object);
+			if (!inserted) {
+				if (it->second == object) {
+					current.redundant_binds++;
+				}
+				it->second = object;
+			}
+		}
+
+		// A deleted object is unbound from every point it was bound to, its name may be reused.
+		void forget(std::initializer_list<point> points, uint64_t object) {
+			for (auto it = bound.begin(); it != bound.end();) {
+				const auto p = static_cast<point>(it->first >> 56);
+				// Indexed ranges keep the buffer in the low bits, see BindBufferRange.
+				const uint64_t name = p == point::buffer_index ? it->second & 0xFFFFFF : it->second;
+				if (name == object && std::find(points.begin(), points.end(), p) != points.end()) {
+					it = bound.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+		}
+
+		void forget(std::initializer_list<point> points, GLsizei n, const GLuint* objects) {
+			for (GLsizei i = 0; i < n; i++) {
+				if (objects[i] != 0) {
+					forget(points, objects[i]);
+				}
+			}
+		}
+
+		bool unpack_buffer_bound() {
+			const auto it = bound.find(static_cast<uint64_t>(point::buffer) << 56 ^ GL_PIXEL_UNPACK_BUFFER);
+			return it != bound.end() && it->second != 0;
+		}
+
+		int64_t image_bytes(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+			int channels = 4;
+			switch (format) {
+			case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: channels = 1; break;
+			case GL_RG: case GL_RG_INTEGER: channels = 2; break;
+			case GL_RGB: case GL_BGR: channels = 3; break;
+			}
+			int size = 4;
+			switch (type) {
+			case GL_UNSIGNED_BYTE: case GL_BYTE: size = 1; break;
+			case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: size = 2; break;
+			}
+			return static_cast<int64_t>(width) * height * channels * size;
+		}
+	}
+
+	void end_frame()
+	{
+		for (int i = 0; i < static_cast<int>(kind::count); i++) {
+			total.calls[i] += current.calls[i];
+			largest.calls[i] = std::max(largest.calls[i], current.calls[i]);
+		}
+		total.redundant_binds += current.redundant_binds;
+		total.bytes_uploaded += current.bytes_uploaded;
+		total.bytes_read_back += current.bytes_read_back;
+		largest.redundant_binds = std::max(largest.redundant_binds, current.redundant_binds);
+		largest.bytes_uploaded = std::max(largest.bytes_uploaded, current.bytes_uploaded);
+		largest.bytes_read_back = std::max(largest.bytes_read_back, current.bytes_read_back);
+		frames++;
+		current = {};
+	}
+
+	const counters& frame()
+	{
+		return current;
+	}
+
+	void print(std::ostream& out)
+	{
+		if (frames == 0) {
+			return;
+		}
+
+		const char* names[] = { "draws", "binds", "state", "uniforms", "clears", "uploads", "readbacks", "syncs",
+			"other GPU work", "queries" };
+		out << "GL calls per frame (mean/max):";
+		for (int i = 0; i < static_cast<int>(kind::count); i++) {
+			out << (i > 0 ? ", " : " ") << names[i] << " " << total.calls[i] / frames << "/" << largest.calls[i];
+		}
+		out << std::endl << "GL redundant binds: " << total.redundant_binds / frames << "/" << largest.redundant_binds
+			<< ", uploaded: " << total.bytes_uploaded / frames / 1024 << "/" << largest.bytes_uploaded / 1024 << " KB"
+			<< ", read back: " << total.bytes_read_back / frames / 1024 << "/" << largest.bytes_read_back / 1024 << " KB"
+			<< std::endl;
+	}
+
+	void ActiveTexture(GLenum texture)
+	{
+		count(kind::state);
+		active_unit = texture - GL_TEXTURE0;
+		glActiveTexture(texture);
+	}
+
+	void BindBuffer(GLenum target, GLuint buffer)
+	{
+		bind(point::buffer, target, buffer);
+		glBindBuffer(target, buffer);
+	}
+
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		bind(point::buffer_index, static_cast<uint64_t>(target) << 32 | index, buffer);
+		glBindBufferBase(target, index, buffer);
+	}
+
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		// A different range of the same buffer is a real change.
+		bind(point::buffer_index, static_cast<uint64_t>(target) << 32 | index,
+			buffer ^ static_cast<uint64_t>(offset) << 24 ^ static_cast<uint64_t>(size) << 44);
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	void BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		bind(point::framebuffer, target, framebuffer);
+		glBindFramebuffer(target, framebuffer);
+	}
+
+	void BindRenderbuffer(GLenum target, GLuint renderbuffer)
+	{
+		bind(point::renderbuffer, target, renderbuffer);
+		glBindRenderbuffer(target, renderbuffer);
+	}
+
+	void BindTexture(GLenum target, GLuint texture)
+	{
+		bind(point::texture, static_cast<uint64_t>(active_unit) << 32 | target, texture);
+		glBindTexture(target, texture);
+	}
+
+	void BindTextureUnit(GLuint unit, GLuint texture)
+	{
+		bind(point::texture_unit, unit, texture);
+		glBindTextureUnit(unit, texture);
+	}
+
+	void BindVertexArray(GLuint array)
+	{
+		bind(point::vertex_array, 0, array);
+		glBindVertexArray(array);
+	}
+
+	void UseProgram(GLuint program)
+	{
+		bind(point::program, 0, program);
+		glUseProgram(program);
+	}
+
+	void DrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		gl_profile::count(kind::draw);
+		glDrawArrays(mode, first, count);
+	}
+
+	void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		gl_profile::count(kind::draw);
+		glDrawElements(mode, count, type, indices);
+	}
+
+	void Clear(GLbitfield mask)
+	{
+		count(kind::clear);
+		glClear(mask);
+	}
+
+	void Enable(GLenum cap)
+	{
+		count(kind::state);
+		glEnable(cap);
+	}
+
+	void Disable(GLenum cap)
+	{
+		count(kind::state);
+		glDisable(cap);
+	}
+
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		count(kind::state);
+		glViewport(x, y, width, height);
+	}
+
+	void DepthFunc(GLenum func)
+	{
+		count(kind::state);
+		glDepthFunc(func);
+	}
+
+	void DepthMask(GLboolean flag)
+	{
+		count(kind::state);
+		glDepthMask(flag);
+	}
+
+	void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		count(kind::state);
+		glClearColor(red, green, blue, alpha);
+	}
+
+	void PixelStorei(GLenum pname, GLint param)
+	{
+		count(kind::state);
+		glPixelStorei(pname, param);
+	}
+
+	void TexParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		count(kind::state);
+		glTexParameteri(target, pname, param);
+	}
+
+	void TextureParameteri(GLuint texture, GLenum pname, GLint param)
+	{
+		count(kind::state);
+		glTextureParameteri(texture, pname, param);
+	}
+
+	void DrawBuffers(GLsizei n, const GLenum* bufs)
+	{
+		count(kind::state);
+		glDrawBuffers(n, bufs);
+	}
+
+	void PolygonOffset(GLfloat factor, GLfloat units)
+	{
+		count(kind::state);
+		glPolygonOffset(factor, units);
+	}
+
+	void BlendFunc(GLenum sfactor, GLenum dfactor)
+	{
+		count(kind::state);
+		glBlendFunc(sfactor, dfactor);
+	}
+
+	void Uniform1i(GLint location, GLint v0)
+	{
+		count(kind::uniform);
+		glUniform1i(location, v0);
+	}
+
+	void Uniform1f(GLint location, GLfloat v0)
+	{
+		count(kind::uniform);
+		glUniform1f(location, v0);
+	}
+
+	void Uniform2f(GLint location, GLfloat v0, GLfloat v1)
+	{
+		count(kind::uniform);
+		glUniform2f(location, v0, v1);
+	}
+
+	void Uniform3fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		gl_profile::count(kind::uniform);
+		glUniform3fv(location, count, value);
+	}
+
+	void ProgramUniform1i(GLuint program, GLint location, GLint v0)
+	{
+		count(kind::uniform);
+		glProgramUniform1i(program, location, v0);
+	}
+
+	GLint GetUniformLocation(GLuint program, const GLchar* name)
+	{
+		count(kind::query);
+		return glGetUniformLocation(program, name);
+	}
+
+	GLboolean IsEnabled(GLenum cap)
+	{
+		count(kind::query);
+		return glIsEnabled(cap);
+	}
+
+	void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		gl_profile::count(kind::uniform);
+		glUniformMatrix4fv(location, count, transpose, value);
+	}
+
+	void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		count(kind::upload);
+		if (data != nullptr) {
+			current.bytes_uploaded += size;
+		}
+		glBufferData(target, size, data, usage);
+	}
+
+	void NamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		count(kind::upload);
+		if (data != nullptr) {
+			current.bytes_uploaded += size;
+		}
+		glNamedBufferData(buffer, size, data, usage);
+	}
+
+	void NamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		count(kind::upload);
+		current.bytes_uploaded += size;
+		glNamedBufferSubData(buffer, offset, size, data);
+	}
+
+	void NamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		count(kind::upload);
+		if (data != nullptr) {
+			current.bytes_uploaded += size;
+		}
+		glNamedBufferStorage(buffer, size, data, flags);
+	}
+
+	void TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+		GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		count(kind::upload);
+		if (pixels != nullptr || unpack_buffer_bound()) {
+			current.bytes_uploaded += image_bytes(width, height, format, type);
+		}
+		glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	}
+
+	void TextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void* pixels)
+	{
+		count(kind::upload);
+		current.bytes_uploaded += image_bytes(width, height, format, type);
+		glTextureSubImage2D(texture, level, xoffset, yoffset, width, height, format, type, pixels);
+	}
+
+	void GetTextureImage(GLuint texture, GLint level, GLenum format, GLenum type, GLsizei bufSize, void* pixels)
+	{
+		count(kind::readback);
+		current.bytes_read_back += bufSize;
+		glGetTextureImage(texture, level, format, type, bufSize, pixels);
+	}
+
+	void DispatchCompute(GLuint x, GLuint y, GLuint z)
+	{
+		count(kind::work);
+		glDispatchCompute(x, y, z);
+	}
+
+	void GenerateTextureMipmap(GLuint texture)
+	{
+		count(kind::work);
+		glGenerateTextureMipmap(texture);
+	}
+
+	void CopyImageSubData(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+		GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ,
+		GLsizei width, GLsizei height, GLsizei depth)
+	{
+		count(kind::work);
+		glCopyImageSubData(srcName, srcTarget, srcLevel, srcX, srcY, srcZ,
+			dstName, dstTarget, dstLevel, dstX, dstY, dstZ, width, height, depth);
+	}
+
+	GLsync FenceSync(GLenum condition, GLbitfield flags)
+	{
+		count(kind::sync);
+		return glFenceSync(condition, flags);
+	}
+
+	GLenum ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		count(kind::sync);
+		return glClientWaitSync(sync, flags, timeout);
+	}
+
+	void DeleteSync(GLsync sync)
+	{
+		count(kind::sync);
+		glDeleteSync(sync);
+	}
+
+	void Barrier(GLbitfield barriers)
+	{
+		count(kind::sync);
+		glMemoryBarrier(barriers);
+	}
+
+	void Flush()
+	{
+		count(kind::sync);
+		glFlush();
+	}
+
+	void DeleteBuffers(GLsizei n, const GLuint* buffers)
+	{
+		forget({ point::buffer, point::buffer_index }, n, buffers);
+		glDeleteBuffers(n, buffers);
+	}
+
+	void DeleteTextures(GLsizei n, const GLuint* textures)
+	{
+		forget({ point::texture, point::texture_unit }, n, textures);
+		glDeleteTextures(n, textures);
+	}
+
+	void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+	{
+		forget({ point::framebuffer }, n, framebuffers);
+		glDeleteFramebuffers(n, framebuffers);
+	}
+
+	void DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+	{
+		forget({ point::renderbuffer }, n, renderbuffers);
+		glDeleteRenderbuffers(n, renderbuffers);
+	}
+
+	void DeleteVertexArrays(GLsizei n, const GLuint* arrays)
+	{
+		forget({ point::vertex_array }, n, arrays);
+		glDeleteVertexArrays(n, arrays);
+	}
+
+	void DeleteProgram(GLuint program)
+	{
+		if (program != 0) {
+			forget({ point::program }, program);
+		}
+		glDeleteProgram(program);
+	}
+}
+
+#endif
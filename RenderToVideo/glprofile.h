@@ -0,0 +1,207 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <ostream>
+
+// GL errors and warnings arrive through the debug output callback, asynchronously,
+// instead of polling glGetError after every call, which makes some drivers wait for
+// the GPU. Without a debug context (see GLFW_OPENGL_DEBUG_CONTEXT) drivers may only
+// report errors.
+// https://www.khronos.org/opengl/wiki/Debug_Output
+void enable_debug_output();
+
+// With RENDER_GL_PROFILE defined, on by default in debug builds, every file that
+// includes this header after <GL/glew.h> calls the GL functions below through
+// counting wrappers: calls by kind, binds of what is already bound, and bytes
+// uploaded and read back. Deleting an object forgets where it was bound, so a
+// recycled name is not taken for a redundant bind. Persistently mapped buffers
+// are not visible to it. In other builds the header only declares enable_debug_output().
+
+#ifdef RENDER_GL_PROFILE
+
+namespace gl_profile {
+	// work is GPU work besides draws: dispatches, copies and mipmap generation.
+	enum class kind { draw, bind, state, uniform, clear, upload, readback, sync, work, query, count };
+
+	struct counters {
+		int64_t calls[static_cast<int>(kind::count)] = {};
+		// Binds of the object that is already bound there, tracked per target and unit.
+		int64_t redundant_binds = 0;
+		int64_t bytes_uploaded = 0;
+		int64_t bytes_read_back = 0;
+	};
+
+	// Closes the counters of the current frame.
+	void end_frame();
+	[[nodiscard]] const counters& frame();
+	// Mean and largest counts per frame over all finished frames.
+	void print(std::ostream& out);
+
+	void ActiveTexture(GLenum texture);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void BindFramebuffer(GLenum target, GLuint framebuffer);
+	void BindRenderbuffer(GLenum target, GLuint renderbuffer);
+	void BindTexture(GLenum target, GLuint texture);
+	void BindTextureUnit(GLuint unit, GLuint texture);
+	void BindVertexArray(GLuint array);
+	void UseProgram(GLuint program);
+
+	void DrawArrays(GLenum mode, GLint first, GLsizei count);
+	void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+	void Clear(GLbitfield mask);
+
+	void Enable(GLenum cap);
+	void Disable(GLenum cap);
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean flag);
+	void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+	void PixelStorei(GLenum pname, GLint param);
+	void TexParameteri(GLenum target, GLenum pname, GLint param);
+	void TextureParameteri(GLuint texture, GLenum pname, GLint param);
+	void DrawBuffers(GLsizei n, const GLenum* bufs);
+	void PolygonOffset(GLfloat factor, GLfloat units);
+	void BlendFunc(GLenum sfactor, GLenum dfactor);
+
+	void Uniform1i(GLint location, GLint v0);
+	void Uniform1f(GLint location, GLfloat v0);
+	void Uniform2f(GLint location, GLfloat v0, GLfloat v1);
+	void Uniform3fv(GLint location, GLsizei count, const GLfloat* value);
+	void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	void ProgramUniform1i(GLuint program, GLint location, GLint v0);
+	GLint GetUniformLocation(GLuint program, const GLchar* name);
+	GLboolean IsEnabled(GLenum cap);
+
+	void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+	void NamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+	void NamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+	void NamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+	void TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+		GLint border, GLenum format, GLenum type, const void* pixels);
+	void TextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const void* pixels);
+	void GetTextureImage(GLuint texture, GLint level, GLenum format, GLenum type, GLsizei bufSize, void* pixels);
+
+	void DispatchCompute(GLuint x, GLuint y, GLuint z);
+	void GenerateTextureMipmap(GLuint texture);
+	void CopyImageSubData(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+		GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ,
+		GLsizei width, GLsizei height, GLsizei depth);
+
+	GLsync FenceSync(GLenum condition, GLbitfield flags);
+	GLenum ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+	void DeleteSync(GLsync sync);
+	// Not MemoryBarrier, which winnt.h defines as a macro.
+	void Barrier(GLbitfield barriers);
+	void Flush();
+
+	void DeleteBuffers(GLsizei n, const GLuint* buffers);
+	void DeleteTextures(GLsizei n, const GLuint* textures);
+	void DeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+	void DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+	void DeleteVertexArrays(GLsizei n, const GLuint* arrays);
+	void DeleteProgram(GLuint program);
+}
+
+// glprofile.cpp itself calls the real functions.
+#ifndef GL_PROFILE_IMPLEMENTATION
+
+#undef glActiveTexture
+#undef glBindBuffer
+#undef glBindBufferBase
+#undef glBindBufferRange
+#undef glBindFramebuffer
+#undef glBindRenderbuffer
+#undef glBindTextureUnit
+#undef glBindVertexArray
+#undef glUseProgram
+#undef glDrawBuffers
+#undef glTextureParameteri
+#undef glUniform1i
+#undef glUniform1f
+#undef glUniform2f
+#undef glUniform3fv
+#undef glUniformMatrix4fv
+#undef glProgramUniform1i
+#undef glGetUniformLocation
+#undef glBlendFunc
+#undef glBufferData
+#undef glNamedBufferData
+#undef glNamedBufferSubData
+#undef glNamedBufferStorage
+#undef glTextureSubImage2D
+#undef glGetTextureImage
+#undef glDispatchCompute
+#undef glGenerateTextureMipmap
+#undef glCopyImageSubData
+#undef glFenceSync
+#undef glClientWaitSync
+#undef glDeleteSync
+#undef glMemoryBarrier
+#undef glDeleteBuffers
+#undef glDeleteFramebuffers
+#undef glDeleteRenderbuffers
+#undef glDeleteVertexArrays
+#undef glDeleteProgram
+
+#define glActiveTexture gl_profile::ActiveTexture
+#define glBindBuffer gl_profile::BindBuffer
+#define glBindBufferBase gl_profile::BindBufferBase
+#define glBindBufferRange gl_profile::BindBufferRange
+#define glBindFramebuffer gl_profile::BindFramebuffer
+#define glBindRenderbuffer gl_profile::BindRenderbuffer
+#define glBindTexture gl_profile::BindTexture
+#define glBindTextureUnit gl_profile::BindTextureUnit
+#define glBindVertexArray gl_profile::BindVertexArray
+#define glUseProgram gl_profile::UseProgram
+#define glDrawArrays gl_profile::DrawArrays
+#define glDrawElements gl_profile::DrawElements
+#define glClear gl_profile::Clear
+#define glEnable gl_profile::Enable
+#define glDisable gl_profile::Disable
+#define glViewport gl_profile::Viewport
+#define glDepthFunc gl_profile::DepthFunc
+#define glDepthMask gl_profile::DepthMask
+#define glClearColor gl_profile::ClearColor
+#define glPixelStorei gl_profile::PixelStorei
+#define glTexParameteri gl_profile::TexParameteri
+#define glTextureParameteri gl_profile::TextureParameteri
+#define glDrawBuffers gl_profile::DrawBuffers
+#define glPolygonOffset gl_profile::PolygonOffset
+#define glBlendFunc gl_profile::BlendFunc
+#define glUniform1i gl_profile::Uniform1i
+#define glUniform1f gl_profile::Uniform1f
+#define glUniform2f gl_profile::Uniform2f
+#define glUniform3fv gl_profile::Uniform3fv
+#define glUniformMatrix4fv gl_profile::UniformMatrix4fv
+#define glProgramUniform1i gl_profile::ProgramUniform1i
+#define glGetUniformLocation gl_profile::GetUniformLocation
+#define glIsEnabled gl_profile::IsEnabled
+#define glBufferData gl_profile::BufferData
+#define glNamedBufferData gl_profile::NamedBufferData
+#define glNamedBufferSubData gl_profile::NamedBufferSubData
+#define glNamedBufferStorage gl_profile::NamedBufferStorage
+#define glTexImage2D gl_profile::TexImage2D
+#define glTextureSubImage2D gl_profile::TextureSubImage2D
+#define glGetTextureImage gl_profile::GetTextureImage
+#define glDispatchCompute gl_profile::DispatchCompute
+#define glGenerateTextureMipmap gl_profile::GenerateTextureMipmap
+#define glCopyImageSubData gl_profile::CopyImageSubData
+#define glFenceSync gl_profile::FenceSync
+#define glClientWaitSync gl_profile::ClientWaitSync
+#define glDeleteSync gl_profile::DeleteSync
+#define glMemoryBarrier gl_profile::Barrier
+#define glFlush gl_profile::Flush
+#define glDeleteBuffers gl_profile::DeleteBuffers
+#define glDeleteTextures gl_profile::DeleteTextures
+#define glDeleteFramebuffers gl_profile::DeleteFramebuffers
+#define glDeleteRenderbuffers gl_profile::DeleteRenderbuffers
+#define glDeleteVertexArrays gl_profile::DeleteVertexArrays
+#define glDeleteProgram gl_profile::DeleteProgram
+
+#endif
+#endif
@@ -0,0 +1,151 @@
+#include "golden.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+uint64_t hash_frame(const unsigned char* data, size_t size)
+{
+	// FNV-1a, 64 bit
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t hash_planes(const unsigned char* data, int width, int height)
+{
+	std::vector<unsigned char> rows;
+	rows.reserve(static_cast<size_t>(height) * 2 * sizeof(uint64_t));
+
+	const size_t y_size = static_cast<size_t>(width) * height;
+	for (int row = 0; row < height * 2; row++) {
+		const size_t offset = row < height ? row * static_cast<size_t>(width) : y_size + (row - height) * static_cast<size_t>(width / 2);
+		const uint64_t hash = hash_frame(data + offset, row < height ? width : width / 2);
+		for (int b = 0; b < 64; b += 8) {
+			rows.push_back(static_cast<unsigned char>(hash >> b));
+		}
+	}
+	return hash_frame(rows.data(), rows.size());
+}
+
+double psnr(const unsigned char* a, const unsigned char* b, size_t size)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i < size; i++) {
+		const int d = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+		sum += static_cast<uint64_t>(d * d);
+	}
+
+	if (sum == 0) {
+		return std::numeric_limits<double>::infinity();
+	}
+
+	const double mse = static_cast<double>(sum) / static_cast<double>(size);
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+double ssim(const unsigned char* a, const unsigned char* b, int width, int height)
+{
+	// Mean SSIM over non-overlapping 8x8 windows.
+	// https://en.wikipedia.org/wiki/Structural_similarity_index_measure
+	constexpr int window = 8;
+	constexpr double c1 = (0.01 * 255) * (0.01 * 255);
+	constexpr double c2 = (0.03 * 255) * (0.03 * 255);
+
+	double total = 0;
+	int windows = 0;
+
+	for (int y0 = 0; y0 + window <= height; y0 += window) {
+		for (int x0 = 0; x0 + window <= width; x0 += window) {
+			double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+			for (int y = y0; y < y0 + window; y++) {
+				for (int x = x0; x < x0 + window; x++) {
+					const double va = a[y * width + x];
+					const double vb = b[y * width + x];
+					sa += va;
+					sb += vb;
+					saa += va * va;
+					sbb += vb * vb;
+					sab += va * vb;
+				}
+			}
+
+			constexpr double n = window * window;
+			const double ma = sa / n;
+			const double mb = sb / n;
+			const double va = saa / n - ma * ma;
+			const double vb = sbb / n - mb * mb;
+			const double cov = sab / n - ma * mb;
+
+			total += ((2 * ma * mb + c1) * (2 * cov + c2))
+				/ ((ma * ma + mb * mb + c1) * (va + vb + c2));
+			windows++;
+		}
+	}
+
+	return windows > 0 ? total / windows : 1.0;
+}
+
+golden::~golden()
+{
+	if (file != nullptr) {
+		fclose(file);
+	}
+}
+
+bool golden::init(const std::string& path, int width, int height, double min_psnr, double min_ssim)
+{
+	if (file != nullptr) {
+		return false;
+	}
+
+	file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		std::cerr << "Golden: cannot open " << path << std::endl;
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->min_psnr = min_psnr;
+	this->min_ssim = min_ssim;
+	expected.resize(static_cast<size_t>(width) * height * 3 / 2);
+	return true;
+}
+
+golden::result golden::compare(const unsigned char* data, size_t size)
+{
+	result res;
+	res.frame = frames++;
+	res.hash = hash_planes(data, width, height);
+
+	if (size != expected.size() || fread(expected.data(), 1, size, file) != size) {
+		std::cerr << "Golden: no reference for frame " << res.frame << std::endl;
+		failures++;
+		return res;
+	}
+
+	res.exact = std::memcmp(expected.data(), data, size) == 0;
+	if (res.exact) {
+		res.psnr = std::numeric_limits<double>::infinity();
+		res.ssim = 1.0;
+		res.passed = true;
+		return res;
+	}
+
+	res.psnr = psnr(expected.data(), data, size);
+	res.ssim = ssim(expected.data(), data, width, height);
+	res.passed = res.psnr >= min_psnr && res.ssim >= min_ssim;
+
+	if (!res.passed) {
+		std::cerr << "Golden: frame " << res.frame << " differs, PSNR " << res.psnr
+			<< " dB (min " << min_psnr << "), SSIM " << res.ssim << " (min " << min_ssim << ")" << std::endl;
+		failures++;
+	}
+
+	return res;
+}
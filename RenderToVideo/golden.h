@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Compares rendered I420 frames against a raw golden video recorded earlier.
+// Frames are hashed for an exact check, a mismatch is then judged with PSNR over
+// all planes and SSIM over luma so that harmless rounding differences between
+// drivers pass while real regressions do not.
+
+[[nodiscard]] uint64_t hash_frame(const unsigned char* data, size_t size);
+// The hash frame_hash computes on the GPU: hash_frame of every row of the three
+// planes, then over the row hashes as little endian bytes.
+[[nodiscard]] uint64_t hash_planes(const unsigned char* data, int width, int height);
+[[nodiscard]] double psnr(const unsigned char* a, const unsigned char* b, size_t size);
+[[nodiscard]] double ssim(const unsigned char* a, const unsigned char* b, int width, int height);
+
+class golden
+{
+public:
+	struct result {
+		int frame = 0;
+		uint64_t hash = 0;
+		bool exact = false;
+		double psnr = 0;
+		double ssim = 0;
+		bool passed = false;
+	};
+
+	virtual ~golden();
+
+	[[nodiscard]] bool init(const std::string& path, int width, int height,
+		double min_psnr = 40.0, double min_ssim = 0.98);
+	result compare(const unsigned char* data, size_t size);
+
+	[[nodiscard]] int get_failures() const { return failures; }
+	[[nodiscard]] int get_frames() const { return frames; }
+
+private:
+	FILE* file = nullptr;
+	int width = 0;
+	int height = 0;
+	double min_psnr = 0;
+	double min_ssim = 0;
+	std::vector<unsigned char> expected;
+	int frames = 0;
+	int failures = 0;
+};
@@ -0,0 +1,18 @@
+# Composites a flat grey I420 input under a scene that draws nothing and expects it back
+# unchanged, which only holds while the YUV decode is the inverse of the encoder.
+# cmake -DRENDER=<RenderToVideo> -DSCENE=<offscreen.scene> -P passthrough.cmake
+string(ASCII 128 grey)
+string(REPEAT "${grey}" 720000 frame)
+file(WRITE grey.yuv "${frame}${frame}")
+
+execute_process(
+    COMMAND ${RENDER} --headless --deterministic --frames 2 --scene ${SCENE} --input grey.yuv --output passthrough.yuv
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "RenderToVideo failed: ${result}")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files grey.yuv passthrough.yuv RESULT_VARIABLE differs)
+if(NOT differs EQUAL 0)
+    message(FATAL_ERROR "The composited frames differ from the input")
+endif()
@@ -0,0 +1,20 @@
+# Renders against cube2.yuv, the first two cube frames with every luma value one step
+# brighter, as another driver's rounding might leave them. Those frames are not bit exact
+# but have to pass within tolerance; frames from later in the animation have to fail.
+# cmake -DRENDER=<RenderToVideo> -DARCHIVE=<cube2.tar.xz> -DFIRST_FRAME=<n> -DEXPECT=<pass|fail> -P tolerance.cmake
+file(ARCHIVE_EXTRACT INPUT ${ARCHIVE})
+
+execute_process(
+    COMMAND ${RENDER} --headless --deterministic --first-frame ${FIRST_FRAME} --frames 2 --output null --golden cube2.yuv
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+message("${output}")
+
+if(EXPECT STREQUAL "pass")
+    if(NOT result EQUAL 0 OR NOT output MATCHES "Golden: 2 of 2 frames match")
+        message(FATAL_ERROR "Frames within tolerance were rejected")
+    endif()
+elseif(NOT result EQUAL 1 OR NOT output MATCHES "Golden: frame 1 differs")
+    message(FATAL_ERROR "Frames that differ were accepted")
+endif()
@@ -0,0 +1,131 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+jobs::jobs(int threads)
+{
+	if (threads <= 0) {
+		threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	}
+
+	for (int i = 0; i < threads; i++) {
+		queues.push_back(std::make_unique<queue>());
+	}
+
+	// Queue 0 belongs to the thread calling parallel_for.
+	for (int i = 1; i < threads; i++) {
+		workers.emplace_back([this, i] { work(i); });
+	}
+}
+
+jobs::~jobs()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void jobs::run(int count, int grain, trampoline fn, const void* ctx)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	grain = std::max(1, grain);
+	if (workers.empty() || count <= grain) {
+		fn(ctx, 0, count);
+		return;
+	}
+
+	const int chunks = (count + grain - 1) / grain;
+	for (auto& q : queues) {
+		q->items.clear();
+		q->front = 0;
+	}
+	for (int c = 0; c < chunks; c++) {
+		const int begin = c * grain;
+		queues[c % queues.size()]->items.push_back({ begin, std::min(begin + grain, count) });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current = fn;
+		context = ctx;
+		remaining = chunks;
+		busy = static_cast<int>(workers.size());
+		generation++;
+	}
+	wake.notify_all();
+
+	drain(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return busy == 0; });
+	current = nullptr;
+	context = nullptr;
+}
+
+void jobs::drain(int self)
+{
+	range r{};
+	while (remaining.load(std::memory_order_acquire) > 0 && pop(self, r)) {
+		current(context, r.begin, r.end);
+		remaining.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+bool jobs::pop(int self, range& out)
+{
+	// Own queue from the back, the most recently dealt and still cache warm chunk.
+	{
+		auto& q = *queues[self];
+		std::lock_guard<std::mutex> lock(q.lock);
+		if (q.items.size() > q.front) {
+			out = q.items.back();
+			q.items.pop_back();
+			return true;
+		}
+	}
+
+	// Then steal from the front of the others, starting with the next thread.
+	const int n = size();
+	for (int i = 1; i < n; i++) {
+		auto& q = *queues[(self + i) % n];
+		std::lock_guard<std::mutex> lock(q.lock);
+		if (q.items.size() > q.front) {
+			out = q.items[q.front++];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void jobs::work(int self)
+{
+	unsigned seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) {
+				return;
+			}
+			seen = generation;
+		}
+
+		drain(self);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy--;
+		}
+		done.notify_one();
+	}
+}
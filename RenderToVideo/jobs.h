@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads with one queue of index ranges each. A call is split
+// into chunks that are dealt out round robin, every thread works through its own queue
+// from the back and steals from the front of the others once it runs dry. The calling
+// thread takes part as well, so a pool of size 1 runs everything inline. Nothing is
+// allocated per call once the queues have grown to the largest chunk count seen.
+
+class jobs
+{
+public:
+	// 0 uses every hardware thread.
+	explicit jobs(int threads = 0);
+	virtual ~jobs();
+
+	// Calls fn(begin, end) on chunks of at most grain indices until [0, count) is covered.
+	template <typename F>
+	void parallel_for(int count, int grain, F&& fn) {
+		using callable = std::remove_reference_t<F>;
+		run(count, grain, [](const void* ctx, int begin, int end) {
+			(*static_cast<callable*>(const_cast<void*>(ctx)))(begin, end);
+		}, &fn);
+	}
+
+	[[nodiscard]] int size() const { return static_cast<int>(queues.size()); }
+
+private:
+	using trampoline = void (*)(const void* ctx, int begin, int end);
+
+	struct range {
+		int begin;
+		int end;
+	};
+
+	struct queue {
+		std::mutex lock;
+		std::vector<range> items;
+		size_t front = 0;
+	};
+
+	void run(int count, int grain, trampoline fn, const void* ctx);
+	void drain(int self);
+	bool pop(int self, range& out);
+	void work(int self);
+
+private:
+	std::vector<std::unique_ptr<queue>> queues;
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	trampoline current = nullptr;
+	const void* context = nullptr;
+	std::atomic<int> remaining{ 0 };
+	int busy = 0;
+	unsigned generation = 0;
+	bool quit = false;
+};
@@ -0,0 +1,122 @@
+#include "mappedfile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mapped_file::~mapped_file()
+{
+	Free();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::init(const std::string& path)
+{
+	if (view != nullptr) {
+		return false;
+	}
+
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+		std::cerr << "Cannot open " << path << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		std::cerr << "Cannot map empty file " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping != nullptr) {
+		view = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (view == nullptr) {
+		std::cerr << "Cannot map " << path << std::endl;
+		Free();
+		return false;
+	}
+
+	length = static_cast<size_t>(file_size.QuadPart);
+	return true;
+}
+
+void mapped_file::Free()
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+	}
+	if (mapping != nullptr) {
+		CloseHandle(mapping);
+	}
+	if (file != nullptr) {
+		CloseHandle(file);
+	}
+	view = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	length = 0;
+}
+
+#else
+
+bool mapped_file::init(const std::string& path)
+{
+	if (view != nullptr) {
+		return false;
+	}
+
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Cannot open " << path << std::endl;
+		return false;
+	}
+
+	struct stat info {};
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		std::cerr << "Cannot map empty file " << path << std::endl;
+		close(fd);
+		return false;
+	}
+
+	// The mapping keeps its own reference to the file.
+	void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED) {
+		std::cerr << "Cannot map " << path << std::endl;
+		return false;
+	}
+
+	// Read ahead, the whole file is about to be consumed front to back.
+	madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+	madvise(address, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+	view = static_cast<const unsigned char*>(address);
+	length = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void mapped_file::Free()
+{
+	if (view != nullptr) {
+		munmap(const_cast<unsigned char*>(view), length);
+	}
+	view = nullptr;
+	length = 0;
+}
+
+#endif
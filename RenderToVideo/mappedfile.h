@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file through the virtual memory system, pages are
+// only read from disk when touched.
+
+class mapped_file
+{
+public:
+	virtual ~mapped_file();
+
+	[[nodiscard]] bool init(const std::string& path);
+
+	[[nodiscard]] const unsigned char* data() const { return view; }
+	[[nodiscard]] size_t size() const { return length; }
+
+private:
+	void Free();
+
+private:
+	const unsigned char* view = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
@@ -0,0 +1,143 @@
+#include "mesh.h"
+#include "glprofile.h"
+#include "mappedfile.h"
+#include "meshfile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace {
+	// Largest of count indices; the index block is not necessarily aligned in the file.
+	template <typename T>
+	uint32_t max_index(const unsigned char* data, uint64_t count) {
+		uint32_t largest = 0;
+		for (uint64_t i = 0; i < count; i++) {
+			T index;
+			std::memcpy(&index, data + i * sizeof(T), sizeof(T));
+			largest = std::max<uint32_t>(largest, index);
+		}
+		return largest;
+	}
+}
+
+mesh::~mesh()
+{
+	Free();
+}
+
+bool mesh::init(const std::string& path)
+{
+	if (vao != 0) {
+		return false;
+	}
+
+	mapped_file file;
+	if (!file.init(path)) {
+		return false;
+	}
+
+	meshfile::header header;
+	if (file.size() < sizeof(header)) {
+		std::cerr << "Mesh: " << path << " is too small" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	// Version 1 had no detail levels, only the full mesh.
+	if (std::memcmp(header.magic, meshfile::magic, sizeof(header.magic)) != 0
+		|| header.version < 1 || header.version > meshfile::version) {
+		std::cerr << "Mesh: " << path << " is not a version " << meshfile::version << " mesh file" << std::endl;
+		return false;
+	}
+
+	if (header.version == 1) {
+		header.lod_count = 0;
+	}
+
+	const uint64_t table_bytes = uint64_t(header.lod_count) * sizeof(meshfile::lod);
+	const uint64_t vertex_bytes = uint64_t(header.vertex_count) * sizeof(meshfile::vertex);
+	const uint64_t index_bytes = uint64_t(header.index_count) * header.index_size;
+	if ((header.index_size != 2 && header.index_size != 4)
+		|| header.index_count % 3 != 0
+		|| header.vertex_offset < sizeof(header) + table_bytes
+		|| header.index_offset < header.vertex_offset + vertex_bytes
+		|| header.index_offset + index_bytes > file.size()) {
+		std::cerr << "Mesh: " << path << " is corrupt" << std::endl;
+		return false;
+	}
+
+	// An index past the vertices would make the GPU read outside the buffer.
+	const auto* indices = file.data() + header.index_offset;
+	if (header.index_count > 0 && (header.index_size == 2 ? max_index<uint16_t>(indices, header.index_count)
+		: max_index<uint32_t>(indices, header.index_count)) >= header.vertex_count) {
+		std::cerr << "Mesh: " << path << " has indices past its " << header.vertex_count << " vertices" << std::endl;
+		return false;
+	}
+
+	levels.clear();
+	for (uint32_t i = 0; i < header.lod_count; i++) {
+		meshfile::lod lod;
+		std::memcpy(&lod, file.data() + sizeof(header) + i * sizeof(lod), sizeof(lod));
+		if (lod.index_count % 3 != 0 || uint64_t(lod.first_index) + lod.index_count > header.index_count) {
+			std::cerr << "Mesh: " << path << " has a corrupt level of detail" << std::endl;
+			return false;
+		}
+		levels.push_back({ static_cast<int>(lod.first_index), static_cast<int>(lod.index_count), lod.error });
+	}
+	if (levels.empty()) {
+		levels.push_back({ 0, static_cast<int>(header.index_count), 0.0f });
+	}
+
+	// One buffer from the first vertex to the last index, sourced directly from the mapping.
+	const auto* blob = file.data() + header.vertex_offset;
+	const auto blob_size = static_cast<GLsizeiptr>(header.index_offset + index_bytes - header.vertex_offset);
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, blob_size, blob, 0);
+
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayVertexBuffer(vao, 0, buffer, 0, sizeof(meshfile::vertex));
+	glVertexArrayElementBuffer(vao, buffer);
+
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(meshfile::vertex, position));
+	glVertexArrayAttribBinding(vao, 0, 0);
+
+	glEnableVertexArrayAttrib(vao, 1);
+	glVertexArrayAttribFormat(vao, 1, 3, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(meshfile::vertex, color));
+	glVertexArrayAttribBinding(vao, 1, 0);
+
+	index_type = header.index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	index_offset = static_cast<GLintptr>(header.index_offset - header.vertex_offset);
+	vertex_count = static_cast<int>(header.vertex_count);
+	box.min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+	box.max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+
+	return true;
+}
+
+glm::mat4 mesh::decode() const
+{
+	// Normalized positions are in [0, 1] along each axis of the bounds.
+	return glm::scale(glm::translate(glm::mat4(1.0f), box.min), box.max - box.min);
+}
+
+void mesh::draw(int lod)
+{
+	const auto& l = levels[lod];
+	const GLintptr first = index_offset + static_cast<GLintptr>(l.first) * (index_type == GL_UNSIGNED_SHORT ? 2 : 4);
+	glBindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, l.count, index_type, reinterpret_cast<const void*>(first));
+	glBindVertexArray(0);
+}
+
+void mesh::Free()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &buffer);
+	vao = 0;
+	buffer = 0;
+}
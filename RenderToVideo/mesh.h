@@ -0,0 +1,48 @@
+#pragma once
+
+#include "drawable.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// A mesh in the binary format of meshfile.h. The file is memory mapped and its
+// vertex and index blobs go to immutable GPU storage in one upload, without
+// parsing or an intermediate copy.
+
+class mesh : public drawable
+{
+public:
+	virtual ~mesh();
+
+	[[nodiscard]] bool init(const std::string& path);
+
+	void draw(int lod = 0) override;
+	[[nodiscard]] aabb bounds() const override { return box; }
+	[[nodiscard]] glm::mat4 decode() const override;
+
+	[[nodiscard]] int lods() const override { return static_cast<int>(levels.size()); }
+	[[nodiscard]] float lod_error(int lod) const override { return levels[lod].error; }
+	[[nodiscard]] int triangles(int lod) const override { return levels[lod].count / 3; }
+
+	[[nodiscard]] int vertices() const { return vertex_count; }
+
+private:
+	void Free();
+
+private:
+	GLuint vao = 0;
+	GLuint buffer = 0;
+	GLenum index_type = GL_UNSIGNED_SHORT;
+	GLintptr index_offset = 0;
+	int vertex_count = 0;
+	aabb box;
+
+	struct level {
+		int first;
+		int count;
+		float error;
+	};
+	std::vector<level> levels;
+};
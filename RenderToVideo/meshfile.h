@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary mesh format written by MeshConverter and mapped by mesh::init.
+// A 64 byte header and the table of detail levels are followed by the vertex
+// blob and the index blob, both in the layout the vertex array reads, so
+// loading is a single upload straight from the mapped file.
+//
+// Positions are quantized to 16 bits per axis inside the bounds and decoded by
+// the vertex shader, colors are 8 bit per channel. Every level of detail is a
+// range of the index blob over the same vertices, finest first.
+
+namespace meshfile {
+	constexpr char magic[4] = { 'R', 'M', 'S', 'H' };
+	constexpr uint32_t version = 2;
+	// Blobs start on this boundary.
+	constexpr uint64_t alignment = 16;
+
+	struct header {
+		char magic[4];
+		uint32_t version;
+		uint32_t vertex_count;
+		uint32_t index_count;
+		uint32_t index_size;		// 2 or 4 bytes
+		uint32_t lod_count;			// entries of the lod table right after the header
+		float bounds_min[3];
+		float bounds_max[3];
+		uint64_t vertex_offset;		// from the start of the file
+		uint64_t index_offset;
+	};
+
+	struct vertex {
+		uint16_t position[4];		// unorm within the bounds, w unused
+		uint8_t color[4];			// unorm rgb, a unused
+	};
+
+	struct lod {
+		uint32_t first_index;
+		uint32_t index_count;
+		float error;				// RMS distance to the full mesh, in object space
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(header) == 64, "header layout");
+	static_assert(sizeof(lod) == 16, "lod layout");
+	static_assert(sizeof(vertex) == 12, "vertex layout");
+}
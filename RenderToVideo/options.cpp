@@ -0,0 +1,249 @@
+#include "options.h"
+#include "platform.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+	bool parse_int(const char* text, int min, int max, int& value) {
+		char* end = nullptr;
+		const long parsed = std::strtol(text, &end, 10);
+		if (end == text || *end != '\0' || parsed < min || parsed > max) {
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+
+	bool parse_float(const char* text, float min, float max, float& value) {
+		char* end = nullptr;
+		const float parsed = std::strtof(text, &end);
+		if (end == text || *end != '\0' || !(parsed >= min && parsed <= max)) {
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+}
+
+bool parse_options(int argc, char** argv, options& opts)
+{
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--frames-in-flight") == 0 && value != nullptr) {
+			if (!parse_int(value, 1, 8, opts.frames_in_flight)) {
+				std::cerr << "Invalid frames in flight: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value != nullptr) {
+			if (!parse_int(value, 0, 1 << 30, opts.frames)) {
+				std::cerr << "Invalid frame count: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--first-frame") == 0 && value != nullptr) {
+			if (!parse_int(value, 0, 1 << 30, opts.first_frame)) {
+				std::cerr << "Invalid first frame: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--workers") == 0 && value != nullptr) {
+			if (!parse_int(value, 0, 256, opts.workers)) {
+				std::cerr << "Invalid worker count: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--fps") == 0 && value != nullptr) {
+			if (!parse_int(value, 1, 1000, opts.fps)) {
+				std::cerr << "Invalid frame rate: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--objects") == 0 && value != nullptr) {
+			if (!parse_int(value, 1, 1 << 24, opts.objects)) {
+				std::cerr << "Invalid object count: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--mesh") == 0 && value != nullptr) {
+			opts.mesh = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--scene") == 0 && value != nullptr) {
+			opts.scene = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--lod-pixels") == 0 && value != nullptr) {
+			if (!parse_float(value, 0.0f, 1000.0f, opts.lod_pixels)) {
+				std::cerr << "Invalid level of detail threshold: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--deterministic") == 0) {
+			opts.deterministic = true;
+		}
+		else if (std::strcmp(arg, "--hold") == 0 && value != nullptr) {
+			if (std::sscanf(value, "%d:%d", &opts.hold_first, &opts.hold_last) != 2
+				|| opts.hold_first < 0 || opts.hold_last < opts.hold_first) {
+				std::cerr << "Invalid hold range: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--headless") == 0) {
+			opts.headless = true;
+		}
+		else if (std::strcmp(arg, "--text") == 0 && value != nullptr) {
+			opts.text = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--font") == 0 && value != nullptr) {
+			opts.font = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--font-size") == 0 && value != nullptr) {
+			if (!parse_int(value, 4, 256, opts.font_size)) {
+				std::cerr << "Invalid font size: " << value << std::endl;
+				return false;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--output") == 0 && value != nullptr) {
+			opts.output = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--resume") == 0) {
+			opts.resume = true;
+		}
+		else if (std::strcmp(arg, "--encode") == 0 && value != nullptr) {
+			opts.encode = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--input") == 0 && value != nullptr) {
+			opts.input = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--input-format") == 0 && value != nullptr) {
+			if (std::strcmp(value, "i420") != 0 && std::strcmp(value, "nv12") != 0) {
+				std::cerr << "Invalid input format: " << value << std::endl;
+				return false;
+			}
+			opts.input_nv12 = std::strcmp(value, "nv12") == 0;
+			i++;
+		}
+		else if (std::strcmp(arg, "--codec") == 0 && value != nullptr) {
+			opts.codec = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--golden") == 0 && value != nullptr) {
+			opts.golden = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--timings") == 0 && value != nullptr) {
+			opts.timings = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--manifest") == 0 && value != nullptr) {
+			opts.manifest = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--verify") == 0 && value != nullptr) {
+			opts.verify = value;
+			i++;
+		}
+		else if (std::strcmp(arg, "--hash") == 0 && value != nullptr) {
+			opts.hash = value;
+			i++;
+		}
+		else {
+			std::cerr << "Unknown argument: " << arg << std::endl;
+			return false;
+		}
+	}
+
+	// Segments are only independent when time comes from the frame number.
+	if ((opts.workers != 1 || opts.first_frame > 0) && !opts.deterministic) {
+		std::cerr << "--workers and --first-frame need --deterministic" << std::endl;
+		return false;
+	}
+	if (!opts.text.empty() && opts.font.empty()) {
+		std::cerr << "--text needs --font" << std::endl;
+		return false;
+	}
+
+	const bool store = std::filesystem::path(opts.output).extension() == ".frames";
+	if (opts.resume && !store) {
+		std::cerr << "--resume needs a .frames output" << std::endl;
+		return false;
+	}
+	if (opts.workers != 1 && store) {
+		std::cerr << "--workers cannot write a frame store" << std::endl;
+		return false;
+	}
+	if (!opts.encode.empty() && opts.encode == opts.output) {
+		std::cerr << "--encode needs a different --output" << std::endl;
+		return false;
+	}
+	if (!opts.hash.empty() && opts.manifest.empty() && opts.verify.empty()) {
+		std::cerr << "--hash needs --manifest or --verify" << std::endl;
+		return false;
+	}
+	if (opts.resume && (!opts.deterministic || opts.workers != 1 || !opts.golden.empty())) {
+		std::cerr << "--resume needs --deterministic and cannot be combined with --workers or --golden" << std::endl;
+		return false;
+	}
+	if (opts.workers != 1 && (opts.frames == 0 || !opts.input.empty() || !opts.golden.empty() || !opts.verify.empty())) {
+		std::cerr << "--workers needs --frames and cannot be combined with --input, --golden or --verify" << std::endl;
+		return false;
+	}
+
+	if (opts.codec.empty()) {
+		opts.codec = default_codec;
+	}
+
+	return true;
+}
+
+void print_usage(const char* program)
+{
+	std::cerr << "usage: " << program << " [options]" << std::endl
+		<< "  --frames-in-flight <1-8>  asynchronous readback depth (default 2)" << std::endl
+		<< "  --frames <n>              stop after n frames" << std::endl
+		<< "  --first-frame <n>         start at this frame of the timeline (deterministic)" << std::endl
+		<< "  --workers <n>             render segments in n processes and join them, 0 for all cores" << std::endl
+		<< "  --fps <n>                 frame rate of the video (default 30)" << std::endl
+		<< "  --objects <n>             objects in the scene (default 1)" << std::endl
+		<< "  --mesh <file.rmesh>       draw a converted mesh instead of the cube" << std::endl
+		<< "  --scene <file>            objects, camera and animation from a scene file" << std::endl
+		<< "  --lod-pixels <n>          error allowed for coarser levels of detail, 0 disables (default 1)" << std::endl
+		<< "  --deterministic           animate from the frame number, not the clock" << std::endl
+		<< "  --hold <first>:<last>     freeze the animation for these frames (deterministic)" << std::endl
+		<< "  --headless                do not show the window" << std::endl
+		<< "  --input <file>            video to draw the scene over, .yuv/.nv12 raw, - for stdin" << std::endl
+		<< "  --input-format <i420|nv12> raw layout of the input (default i420)" << std::endl
+		<< "  --text <utf8>             caption over every frame, {frame} becomes the frame number" << std::endl
+		<< "  --font <file.ttf>         font of the caption" << std::endl
+		<< "  --font-size <n>           caption size in points (default 24)" << std::endl
+		<< "  --output <file>           video to write, .yuv for raw I420, .frames for a frame store, null (default test.mkv)" << std::endl
+		<< "  --resume                  continue an interrupted .frames output after its last complete frame" << std::endl
+		<< "  --encode <file.frames>    encode a frame store to --output without rendering" << std::endl
+		<< "  --codec <name>            ffmpeg encoder (default " << default_codec << ")" << std::endl
+		<< "  --golden <file.yuv>       compare every frame against a raw I420 reference" << std::endl
+		<< "  --timings <file.csv>      write per-frame time and hash" << std::endl
+		<< "  --manifest <file>         write the GPU hash of every frame" << std::endl
+		<< "  --verify <manifest>       fail unless every frame matches the hash in a manifest" << std::endl
+		<< "  --hash <file.yuv>         hash raw frames on the CPU for --manifest or --verify" << std::endl;
+}
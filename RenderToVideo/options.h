@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+
+// Command line of RenderToVideo.
+
+struct options
+{
+	// Frames read back asynchronously before the CPU waits on the oldest one.
+	int frames_in_flight = 2;
+	// Stop after this many frames, 0 renders until the window is closed.
+	int frames = 0;
+	// Timeline position of the first frame, to render a segment of a longer video.
+	int first_frame = 0;
+	// Processes that each render and encode a segment, 0 for one per core.
+	int workers = 1;
+	int fps = 30;
+	// Objects in the scene.
+	int objects = 1;
+	// Binary mesh from MeshConverter drawn instead of the cube.
+	std::string mesh;
+	// Scene file with objects, camera and keyframes, replaces objects and mesh.
+	std::string scene;
+	// Largest error in pixels a coarser level of detail may introduce, 0 disables them.
+	float lod_pixels = 1.0f;
+	// Animate from frame_no / fps instead of the wall clock.
+	bool deterministic = false;
+	// Frames [hold_first, hold_last] freeze the animation, e.g. for a title card.
+	// Only meaningful together with deterministic.
+	int hold_first = -1;
+	int hold_last = -1;
+	// Do not show the window, e.g. when rendering with llvmpipe under Xvfb.
+	bool headless = false;
+	// Video to composite the scene over, see video_source::init.
+	std::string input;
+	// Raw layout of the input, I420 or NV12.
+	bool input_nv12 = false;
+	// UTF-8 caption drawn over every frame, {frame} is replaced by the frame number.
+	std::string text;
+	// TrueType font of the caption and its size in points.
+	std::string font;
+	int font_size = 24;
+	// A .yuv extension writes raw I420, .frames a frame store, "null" discards, anything else is encoded by ffmpeg.
+	std::string output = "test.mkv";
+	// Keep the complete frames of an existing .frames output and render the rest.
+	bool resume = false;
+	// Frame store to encode to output instead of rendering.
+	std::string encode;
+	// ffmpeg video encoder, empty picks the platform default.
+	std::string codec;
+	// Raw I420 reference to compare every frame against.
+	std::string golden;
+	// CSV with per-frame time and hash.
+	std::string timings;
+	// Sidecar with the GPU hash of every frame, see frame_hash.
+	std::string manifest;
+	// Manifest of an earlier render every frame has to match exactly.
+	std::string verify;
+	// Raw I420 file to hash on the CPU against verify or into manifest instead of rendering.
+	std::string hash;
+};
+
+[[nodiscard]] bool parse_options(int argc, char** argv, options& opts);
+void print_usage(const char* program);
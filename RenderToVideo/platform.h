@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// The few C runtime calls that are spelled differently by MSVC and POSIX.
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+
+inline FILE* open_pipe(const char* command) { return _popen(command, "wb"); }
+inline FILE* open_read_pipe(const char* command) { return _popen(command, "rb"); }
+inline int close_pipe(FILE* pipe) { return _pclose(pipe); }
+inline size_t write_unlocked(const void* data, size_t size, FILE* file) { return _fwrite_nolock(data, 1, size, file); }
+inline size_t read_unlocked(void* data, size_t size, FILE* file) { return _fread_nolock(data, 1, size, file); }
+inline FILE* binary_stdin() { _setmode(_fileno(stdin), _O_BINARY); return stdin; }
+// One argument of a command line, split again by the CommandLineToArgvW rules.
+inline std::string quote_argument(const std::string& arg)
+{
+	std::string out = "\"";
+	size_t backslashes = 0;
+	for (char c : arg) {
+		if (c == '\\') {
+			backslashes++;
+			continue;
+		}
+		out.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+		backslashes = 0;
+		out += c;
+	}
+	out.append(backslashes * 2, '\\');
+	out += '"';
+	return out;
+}
+constexpr const char* ffmpeg_executable = "ffmpeg.exe";
+constexpr const char* default_codec = "h264_nvenc";
+#else
+#include <signal.h>
+
+// A reader that exits makes the write fail instead of killing the process with SIGPIPE.
+inline FILE* open_pipe(const char* command) { signal(SIGPIPE, SIG_IGN); return popen(command, "w"); }
+inline FILE* open_read_pipe(const char* command) { return popen(command, "r"); }
+inline int close_pipe(FILE* pipe) { return pclose(pipe); }
+inline size_t write_unlocked(const void* data, size_t size, FILE* file) { return fwrite_unlocked(data, 1, size, file); }
+inline size_t read_unlocked(void* data, size_t size, FILE* file) { return fread_unlocked(data, 1, size, file); }
+inline FILE* binary_stdin() { return stdin; }
+// One argument of a shell command, taken literally: single quotes, a quote as '\''.
+inline std::string quote_argument(const std::string& arg)
+{
+	std::string out = "'";
+	for (char c : arg) {
+		if (c == '\'') {
+			out += "'\\''";
+		}
+		else {
+			out += c;
+		}
+	}
+	out += '\'';
+	return out;
+}
+constexpr const char* ffmpeg_executable = "ffmpeg";
+constexpr const char* default_codec = "libx264";
+#endif
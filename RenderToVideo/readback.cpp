@@ -0,0 +1,174 @@
+#include "readback.h"
+#include "glprofile.h"
+
+#include <algorithm>
+#include <iostream>
+
+readback::~readback()
+{
+	Free();
+}
+
+bool readback::init(GLsizei width, GLsizei height, int frames_in_flight, consume_fn consume, hash_fn on_hash)
+{
+	if (!slots.empty() || frames_in_flight < 1 || (!consume && !on_hash)) {
+		return false;
+	}
+	if (on_hash && !hasher.init(width, height, frames_in_flight)) {
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->consume = std::move(consume);
+	this->on_hash = std::move(on_hash);
+	y_size = static_cast<size_t>(width) * height;
+	uv_size = y_size / 4;
+
+	// Frames that are only hashed never leave video memory.
+	const GLbitfield flags = this->consume ? GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT : 0;
+	slots.resize(frames_in_flight);
+	for (auto& s : slots) {
+		glCreateBuffers(1, &s.pbo);
+		glNamedBufferStorage(s.pbo, y_size + 2 * uv_size, nullptr, flags);
+	}
+
+	return true;
+}
+
+void readback::push(const yuv& planes)
+{
+	auto& s = slots[head];
+
+	// U and V are read from the level with half the resolution.
+	for (int channel = 1; channel < 3; channel++) {
+		glGenerateTextureMipmap(planes.get_texture(channel));
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+
+	// With a pack buffer bound the pointer argument is an offset into it.
+	glGetTextureImage(planes.get_texture(0), 0, GL_RED, GL_UNSIGNED_BYTE,
+		static_cast<GLsizei>(y_size), nullptr);
+	for (int channel = 1; channel < 3; channel++) {
+		glGetTextureImage(planes.get_texture(channel), 1, GL_RED, GL_UNSIGNED_BYTE, static_cast<GLsizei>(uv_size),
+			reinterpret_cast<void*>(y_size + (channel - 1) * uv_size));
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (on_hash) {
+		hasher.dispatch(s.pbo, head);
+	}
+
+	s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s.pushed = clock::now();
+
+	head = (head + 1) % depth();
+	in_flight++;
+
+	// Keep at most depth - 1 frames pending, so depth 1 is fully synchronous.
+	if (in_flight == depth()) {
+		retire();
+	}
+}
+
+void readback::repeat()
+{
+	counters.repeats++;
+
+	// Still in flight: emit it once more when it retires.
+	if (in_flight > 0) {
+		slots[(head - 1 + depth()) % depth()].repeats++;
+		return;
+	}
+
+	// Already retired: its buffer is the last one to be reused, so it still holds the frame.
+	if (last_retired < 0) {
+		return;
+	}
+
+	if (consume) {
+		const auto size = y_size + 2 * uv_size;
+		const auto* data = static_cast<const GLubyte*>(
+			glMapNamedBufferRange(slots[last_retired].pbo, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT));
+		if (data != nullptr) {
+			consume(data, size);
+		}
+		glUnmapNamedBuffer(slots[last_retired].pbo);
+	}
+	if (on_hash) {
+		on_hash(last_hash);
+	}
+}
+
+void readback::drain()
+{
+	while (in_flight > 0) {
+		retire();
+	}
+}
+
+void readback::retire()
+{
+	const int tail = (head - in_flight + depth()) % depth();
+	auto& s = slots[tail];
+
+	const auto wait_start = clock::now();
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;) {
+		const GLenum result = glClientWaitSync(s.fence, flags, 1'000'000'000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+			break;
+		}
+		if (result == GL_WAIT_FAILED) {
+			std::cerr << "Readback: fence wait failed" << std::endl;
+			break;
+		}
+		flags = 0;
+	}
+	glDeleteSync(s.fence);
+	s.fence = nullptr;
+
+	const auto done = clock::now();
+	if (consume) {
+		const auto size = y_size + 2 * uv_size;
+		const auto* data = static_cast<const GLubyte*>(
+			glMapNamedBufferRange(s.pbo, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT));
+		if (data != nullptr) {
+			for (int i = 0; i <= s.repeats; i++) {
+				consume(data, size);
+			}
+		}
+		glUnmapNamedBuffer(s.pbo);
+	}
+	if (on_hash) {
+		last_hash = hasher.result(tail);
+		for (int i = 0; i <= s.repeats; i++) {
+			on_hash(last_hash);
+		}
+	}
+	s.repeats = 0;
+	last_retired = tail;
+
+	const double latency = std::chrono::duration<double, std::milli>(done - s.pushed).count();
+	counters.frames++;
+	counters.latency_ms += (latency - counters.latency_ms) / counters.frames;
+	counters.max_latency_ms = std::max(counters.max_latency_ms, latency);
+	counters.wait_ms += std::chrono::duration<double, std::milli>(done - wait_start).count();
+
+	in_flight--;
+}
+
+void readback::Free()
+{
+	for (auto& s : slots) {
+		if (s.fence != nullptr) {
+			glDeleteSync(s.fence);
+		}
+		glDeleteBuffers(1, &s.pbo);
+	}
+	slots.clear();
+	in_flight = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "framehash.h"
+#include "yuv.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Asynchronous readback of the I420 planes through a ring of pixel pack buffers.
+// Each pushed frame gets its own PBO and fence, the CPU only blocks when all slots
+// are in use, so depth N lets N-1 frames of GPU work overlap the consumer and
+// depth 1 reads back synchronously.
+// With a hash callback every frame is also hashed on the GPU, see frame_hash.
+// https://www.songho.ca/opengl/gl_pbo.html
+
+class readback
+{
+public:
+	// Receives one tightly packed I420 frame: Y, then U, then V.
+	using consume_fn = std::function<void(const GLubyte* data, size_t size)>;
+	// Receives the hash of each frame, in the same order.
+	using hash_fn = std::function<void(uint64_t hash)>;
+
+	struct stats {
+		int frames = 0;
+		double latency_ms = 0;		// mean push to consume
+		double max_latency_ms = 0;
+		double wait_ms = 0;			// total time blocked on fences
+		int repeats = 0;			// frames emitted by repeat()
+	};
+
+	virtual ~readback();
+
+	// Without consume the frames stay on the GPU and are only hashed.
+	[[nodiscard]] bool init(GLsizei width, GLsizei height, int frames_in_flight, consume_fn consume,
+		hash_fn on_hash = nullptr);
+
+	// Queue the planes of the current frame, retire the oldest one if the ring is full.
+	void push(const yuv& planes);
+	// Emit the previous frame again without any GPU work, for frames where nothing changed.
+	void repeat();
+	// Retire every frame still in flight, in order.
+	void drain();
+
+	[[nodiscard]] int depth() const { return static_cast<int>(slots.size()); }
+	[[nodiscard]] const stats& get_stats() const { return counters; }
+
+private:
+	void retire();
+	void Free();
+
+	using clock = std::chrono::high_resolution_clock;
+
+	struct slot {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		clock::time_point pushed;
+		int repeats = 0;
+	};
+
+private:
+	GLsizei width = 0;
+	GLsizei height = 0;
+	size_t y_size = 0;
+	size_t uv_size = 0;
+	std::vector<slot> slots;
+	int head = 0;
+	int in_flight = 0;
+	int last_retired = -1;
+	consume_fn consume;
+	hash_fn on_hash;
+	frame_hash hasher;
+	uint64_t last_hash = 0;
+	stats counters;
+};
@@ -1,4 +1,5 @@
 #include "rendertarget.h"
+#include "glprofile.h"
 
 #include <iostream>
 
@@ -31,7 +32,7 @@ namespace {
 		}
 	}
 
-	GLuint compile_shaders() {
+	GLuint compile_shaders(const char* frag_src) {
 		const char* vert_src = R"(
 			#version 330 core
 			layout(location = 0) in vec3 pos;
@@ -44,19 +45,6 @@ namespace {
 			}
 		)";
 
-		// 			#layout(location = 0) out vec4 frag_rgba;
-		//			#layout(location = 1) out vec3 frag_norm;
-		const char* frag_src = R"(
-			#version 330 core
-			uniform sampler2D tex0;
-			in vec2 uv;
-			layout(location = 0) out vec3 color;
-
-			void main() {
-				color = texture(tex0, uv).xyz;
-			}
-		)";
-		
 		GLuint vert = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vert, 1, &vert_src, nullptr);
 		glCompileShader(vert);
@@ -88,12 +76,38 @@ namespace {
 		return prog;
 	}
 
-	void checkError() {
-		auto err = glGetError();
-		if (err != 0) {
-			std::cerr << "GL error: " << err << std::endl;
+	// 			#layout(location = 0) out vec4 frag_rgba;
+	//			#layout(location = 1) out vec3 frag_norm;
+	const char* copy_frag_src = R"(
+		#version 330 core
+		uniform sampler2D tex0;
+		in vec2 uv;
+		layout(location = 0) out vec3 color;
+
+		void main() {
+			color = texture(tex0, uv).xyz;
 		}
-	}
+	)";
+
+	// The exact inverse of toYUV in yuv.cpp, so footage passes through the compositor unchanged.
+	// https://en.wikipedia.org/wiki/Y%E2%80%B2UV#SDTV_with_BT.601
+	const char* yuv_frag_src = R"(
+		#version 330 core
+		uniform sampler2D plane_y;
+		uniform sampler2D plane_u;
+		uniform sampler2D plane_v;
+		uniform bool interleaved;
+		in vec2 uv;
+		layout(location = 0) out vec3 color;
+
+		void main() {
+			float y = texture(plane_y, uv).r - 0.0625;
+			vec2 c = interleaved ? texture(plane_u, uv).rg
+				: vec2(texture(plane_u, uv).r, texture(plane_v, uv).r);
+			c -= 0.5;
+			color = vec3(y + 1.139835 * c.y, y - 0.394646 * c.x - 0.580594 * c.y, y + 2.032112 * c.x);
+		}
+	)";
 }
 
 RenderTarget::~RenderTarget()
@@ -112,17 +126,14 @@ bool RenderTarget::init(GLsizei width, GLsizei height)
 
 	glGenFramebuffers(1, &fbo);
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	checkError();
 
 	glGenTextures(1, &tex);
 	glBindTexture(GL_TEXTURE_2D, tex);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 
 		0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
 	glGenerateTextureMipmap(tex);
-	checkError();
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	checkError();
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	glGenRenderbuffers(1, &depth);
@@ -131,14 +142,11 @@ bool RenderTarget::init(GLsizei width, GLsizei height)
 		width, height);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 
 		GL_RENDERBUFFER, depth);
-	checkError();
 
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex, 0);
-	checkError();
 
 	GLenum DrawBuffers[1]{ GL_COLOR_ATTACHMENT0 };
 	glDrawBuffers(1, DrawBuffers);
-	checkError();
 
 	auto status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
 
@@ -160,6 +168,41 @@ bool RenderTarget::init(GLsizei width, GLsizei height)
 	return status == GL_FRAMEBUFFER_COMPLETE && InitTextureToScreen();
 }
 
+bool RenderTarget::init_depth(GLsizei width, GLsizei height)
+{
+	if (fbo > 0) {
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &depth_tex);
+	glTextureStorage2D(depth_tex, 1, GL_DEPTH_COMPONENT24, width, height);
+	// Linear filtering of the comparison result is a 2x2 PCF for free.
+	glTextureParameteri(depth_tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(depth_tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(depth_tex, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(depth_tex, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	// Nothing outside the map is in shadow.
+	const GLfloat border[4]{ 1, 1, 1, 1 };
+	glTextureParameteri(depth_tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(depth_tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTextureParameterfv(depth_tex, GL_TEXTURE_BORDER_COLOR, border);
+
+	glCreateFramebuffers(1, &fbo);
+	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depth_tex, 0);
+	glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+	glNamedFramebufferReadBuffer(fbo, GL_NONE);
+
+	const auto status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Depth framebuffer status: " << status << std::endl;
+		return false;
+	}
+	return true;
+}
+
 void RenderTarget::Begin()
 {
 	if (fbo == 0) {
@@ -183,9 +226,7 @@ void RenderTarget::RenderTexture(int width, int height, GLuint texture)
 {
 	glViewport(0, 0, width, height);
 	
-	checkError();
 	glUseProgram(program_id);
-	checkError();
 	GLuint texLoc = glGetUniformLocation(program_id, "tex0");
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, texture == 0 ? tex : texture);
@@ -198,26 +239,58 @@ void RenderTarget::RenderTexture(int width, int height, GLuint texture)
 	glUseProgram(0);
 }
 
+void RenderTarget::RenderYUV(GLuint y, GLuint u, GLuint v)
+{
+	glViewport(0, 0, width, height);
+
+	const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+
+	glUseProgram(yuv_program_id);
+	glUniform1i(interleaved_location, v == 0);
+	glBindTextureUnit(0, y);
+	glBindTextureUnit(1, u);
+	glBindTextureUnit(2, v);
+
+	glBindVertexArray(quad_vert_arr_id);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glBindVertexArray(0);
+
+	for (GLuint unit = 0; unit < 3; unit++) {
+		glBindTextureUnit(unit, 0);
+	}
+	glUseProgram(0);
+
+	glDepthMask(GL_TRUE);
+	if (depth_test) {
+		glEnable(GL_DEPTH_TEST);
+	}
+}
+
 bool RenderTarget::InitTextureToScreen()
 {
 	// The fullscreen quad's FBO
 	glGenVertexArrays(1, &quad_vert_arr_id);
 	glBindVertexArray(quad_vert_arr_id);
-	checkError();
 
 	glGenBuffers(1, &quad_vert_buffer_id);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vert_buffer_id);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertex_buffer_data), quad_vertex_buffer_data, GL_STATIC_DRAW);
-	checkError();
 
 	glEnableVertexAttribArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vert_buffer_id);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-	checkError();
 
 	glBindVertexArray(0);
 
-	program_id = compile_shaders();
+	program_id = compile_shaders(copy_frag_src);
+	yuv_program_id = compile_shaders(yuv_frag_src);
+	// The planes are always on units 0 to 2, only the layout changes per draw.
+	glProgramUniform1i(yuv_program_id, glGetUniformLocation(yuv_program_id, "plane_y"), 0);
+	glProgramUniform1i(yuv_program_id, glGetUniformLocation(yuv_program_id, "plane_u"), 1);
+	glProgramUniform1i(yuv_program_id, glGetUniformLocation(yuv_program_id, "plane_v"), 2);
+	interleaved_location = glGetUniformLocation(yuv_program_id, "interleaved");
 	return true;
 }
 
@@ -227,6 +300,9 @@ void RenderTarget::Free()
 	glDeleteFramebuffers(1, &fbo);
 	glDeleteTextures(1, &tex);
 	glDeleteRenderbuffers(1, &depth);
+	glDeleteTextures(1, &depth_tex);
 	glDeleteBuffers(1, &quad_vert_buffer_id);
 	glDeleteVertexArrays(1, &quad_vert_arr_id);
+	glDeleteProgram(program_id);
+	glDeleteProgram(yuv_program_id);
 }
@@ -9,11 +9,17 @@ public:
 	virtual ~RenderTarget();
 
 	[[nodiscard]] bool init(GLsizei width, GLsizei height);
+	// Depth only, e.g. a shadow map. The depth texture compares in the sampler (sampler2DShadow).
+	[[nodiscard]] bool init_depth(GLsizei width, GLsizei height);
 	void Begin();
 	void End();
 
 	void RenderTexture(int width, int height, GLuint texture = 0);
+	// Fills the target with video planes converted to RGB, without touching depth.
+	// A zero v plane means u holds interleaved chroma (NV12).
+	void RenderYUV(GLuint y, GLuint u, GLuint v);
 	[[nodiscard]] GLuint get_texture() const { return tex; }
+	[[nodiscard]] GLuint get_depth_texture() const { return depth_tex; }
 
 private:
 	bool InitTextureToScreen();
@@ -25,7 +31,10 @@ private:
 	GLuint fbo = 0;
 	GLuint tex = 0;
 	GLuint depth = 0;
+	GLuint depth_tex = 0;
 	GLuint quad_vert_arr_id = 0;
 	GLuint quad_vert_buffer_id = 0;
 	GLuint program_id = 0;
+	GLuint yuv_program_id = 0;
+	GLint interleaved_location = -1;
 };
@@ -0,0 +1,171 @@
+#include "scene.h"
+#include "frustum.h"
+
+#include <algorithm>
+
+namespace {
+	// Subtrees handed to each worker, more than one evens out unbalanced visibility.
+	constexpr int subtrees_per_worker = 4;
+	constexpr int max_depth = 64;
+}
+
+scene::scene(jobs& workers)
+	: workers(workers)
+{
+}
+
+int scene::add(drawable* mesh, const aabb& bounds, const glm::mat4& transform)
+{
+	const int id = static_cast<int>(meshes.size());
+	meshes.push_back(mesh);
+	local_bounds.push_back(bounds);
+	transforms.push_back(transform);
+	world_bounds.push_back(::transform(bounds, transform));
+	is_moved.push_back(0);
+	rebuild = true;
+	return id;
+}
+
+void scene::set_transform(int id, const glm::mat4& transform)
+{
+	transforms[id] = transform;
+	if (!is_moved[id]) {
+		is_moved[id] = 1;
+		moved.push_back(id);
+	}
+}
+
+void scene::moved_all()
+{
+	moved.resize(meshes.size());
+	for (int id = 0; id < size(); id++) {
+		moved[id] = id;
+		is_moved[id] = 1;
+	}
+}
+
+void scene::mark_moved(const std::vector<int>& ids)
+{
+	for (int id : ids) {
+		if (!is_moved[id]) {
+			is_moved[id] = 1;
+			moved.push_back(id);
+		}
+	}
+}
+
+void scene::update()
+{
+	workers.parallel_for(static_cast<int>(moved.size()), 256, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const int id = moved[i];
+			world_bounds[id] = ::transform(local_bounds[id], transforms[id]);
+			is_moved[id] = 0;
+		}
+	});
+
+	if (!rebuild && !moved.empty()) {
+		tree.refit(world_bounds, moved);
+		rebuild = tree.degraded();
+		if (!rebuild) {
+			const auto& positions = tree.positions();
+			for (int id : moved) {
+				leaf_boxes.set(positions[id], world_bounds[id]);
+			}
+		}
+	}
+	moved.clear();
+
+	if (rebuild) {
+		tree.build(world_bounds);
+		leaf_boxes.resize(world_bounds.size());
+		const auto& order = tree.order();
+		for (size_t i = 0; i < order.size(); i++) {
+			leaf_boxes.set(i, world_bounds[order[i]]);
+		}
+		rebuild = false;
+	}
+}
+
+void scene::collect_subtrees(int index, int target)
+{
+	const auto& n = tree.nodes()[index];
+	if (n.leaf() || n.count <= target) {
+		subtrees.push_back(index);
+		return;
+	}
+	collect_subtrees(index + 1, target);
+	collect_subtrees(n.right, target);
+}
+
+void scene::cull(const glm::mat4& view_proj, std::vector<int>& draw_list)
+{
+	draw_list.clear();
+	stats = cull_stats();
+	if (tree.nodes().empty()) {
+		return;
+	}
+
+	const frustum view(view_proj);
+	const auto& nodes = tree.nodes();
+
+	subtrees.clear();
+	const int target = std::max(bvh::leaf_size, size() / (workers.size() * subtrees_per_worker));
+	collect_subtrees(0, target);
+
+	visible_count.assign(subtrees.size(), 0);
+	tested_count.assign(subtrees.size(), 0);
+	scratch.resize(size());
+
+	// Every subtree covers a contiguous range of the leaf order and writes its
+	// visible objects to the start of that range, so workers never overlap.
+	workers.parallel_for(static_cast<int>(subtrees.size()), 1, [&](int begin, int end) {
+		for (int s = begin; s < end; s++) {
+			int* out = &scratch[nodes[subtrees[s]].first];
+			int visible = 0;
+			int tested = 0;
+
+			int stack[max_depth];
+			int top = 0;
+			stack[top++] = subtrees[s];
+
+			while (top > 0) {
+				const auto& n = nodes[stack[--top]];
+				const auto result = view.test(n.bounds);
+
+				if (result == frustum::result::outside) {
+					continue;
+				}
+
+				if (result == frustum::result::inside) {
+					for (int i = n.first; i < n.first + n.count; i++) {
+						out[visible++] = i;
+					}
+				}
+				else if (n.leaf()) {
+					visible += view.cull(leaf_boxes, n.first, n.count, out + visible);
+					tested += n.count;
+				}
+				else {
+					stack[top++] = n.right;
+					stack[top++] = static_cast<int>(&n - nodes.data()) + 1;
+				}
+			}
+
+			visible_count[s] = visible;
+			tested_count[s] = tested;
+		}
+	});
+
+	const auto& order = tree.order();
+	for (size_t s = 0; s < subtrees.size(); s++) {
+		const int* found = &scratch[nodes[subtrees[s]].first];
+		for (int i = 0; i < visible_count[s]; i++) {
+			draw_list.push_back(order[found[i]]);
+		}
+		stats.tested += tested_count[s];
+	}
+
+	stats.drawn = static_cast<int>(draw_list.size());
+	stats.culled = size() - stats.drawn;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "bounds.h"
+#include "bvh.h"
+#include "drawable.h"
+#include "jobs.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// The objects the engine draws, with world space bounds kept in a BVH so that
+// frustum culling only looks at the parts of the scene that can be visible.
+
+class scene
+{
+public:
+	struct cull_stats {
+		int tested = 0;		// objects tested individually against the frustum
+		int culled = 0;		// objects rejected, individually or with their subtree
+		int drawn = 0;
+	};
+
+	explicit scene(jobs& workers);
+
+	int add(drawable* mesh, const aabb& local_bounds, const glm::mat4& transform);
+	void set_transform(int id, const glm::mat4& transform);
+
+	[[nodiscard]] const glm::mat4& transform(int id) const { return transforms[id]; }
+
+	// Bulk access for writing every transform at once, followed by moved_all() or
+	// mark_moved() with the objects whose transform changed.
+	[[nodiscard]] glm::mat4* transform_data() { return transforms.data(); }
+	void moved_all();
+	void mark_moved(const std::vector<int>& ids);
+	[[nodiscard]] drawable& mesh(int id) const { return *meshes[id]; }
+	[[nodiscard]] int size() const { return static_cast<int>(meshes.size()); }
+
+	// Brings world bounds and the hierarchy up to date with the moved objects.
+	void update();
+
+	// Replaces draw_list with the ids of the objects inside the frustum.
+	void cull(const glm::mat4& view_proj, std::vector<int>& draw_list);
+	[[nodiscard]] const cull_stats& get_stats() const { return stats; }
+
+private:
+	void collect_subtrees(int node, int target);
+
+private:
+	jobs& workers;
+
+	std::vector<drawable*> meshes;
+	std::vector<aabb> local_bounds;
+	std::vector<glm::mat4> transforms;
+	std::vector<aabb> world_bounds;
+	std::vector<int> moved;
+	std::vector<char> is_moved;
+
+	bvh tree;
+	bool rebuild = true;
+	// World bounds in leaf order, for batched tests of a leaf's objects.
+	aabb_soa leaf_boxes;
+
+	// Per-subtree culling state, reused from frame to frame.
+	std::vector<int> subtrees;
+	std::vector<int> visible_count;
+	std::vector<int> tested_count;
+	std::vector<int> scratch;
+
+	cull_stats stats;
+};
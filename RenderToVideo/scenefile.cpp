@@ -0,0 +1,319 @@
+#include "scenefile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	struct key {
+		float time;
+		glm::vec4 value;
+		animation::interpolation mode;
+	};
+
+	enum channel_index {
+		position_keys,
+		rotation_keys,
+		scale_keys,
+		object_channels
+	};
+
+	struct staged_object {
+		scene_file::object data;
+		std::vector<key> keys[object_channels];
+	};
+
+	bool read_vec3(std::istream& in, glm::vec3& v) {
+		return static_cast<bool>(in >> v.x >> v.y >> v.z);
+	}
+
+	// An optional trailing field: absent leaves value as it is, present has to parse.
+	template <typename T>
+	bool read_optional(std::istream& in, T& value) {
+		if ((in >> std::ws).eof()) {
+			return true;
+		}
+		return static_cast<bool>(in >> value);
+	}
+
+	bool read_optional_vec3(std::istream& in, glm::vec3& v) {
+		if ((in >> std::ws).eof()) {
+			return true;
+		}
+		return read_vec3(in, v);
+	}
+
+	// Axis and angle in degrees to a quaternion.
+	bool read_rotation(std::istream& in, glm::vec4& q) {
+		glm::vec3 axis;
+		float degrees = 0;
+		if (!read_vec3(in, axis) || !(in >> degrees) || glm::length(axis) == 0) {
+			return false;
+		}
+		const float half = glm::radians(degrees) / 2;
+		axis = glm::normalize(axis) * std::sin(half);
+		q = glm::vec4(axis, std::cos(half));
+		return true;
+	}
+
+	bool read_mode(std::istream& in, animation::interpolation& mode) {
+		std::string name;
+		if (!(in >> name)) {
+			mode = animation::interpolation::linear;
+			return true;
+		}
+		if (name == "step") {
+			mode = animation::interpolation::step;
+		}
+		else if (name == "linear") {
+			mode = animation::interpolation::linear;
+		}
+		else if (name == "ease") {
+			mode = animation::interpolation::ease;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	void add_keys(animation& timeline, int object, animation::property what, std::vector<key> keys) {
+		if (keys.empty()) {
+			return;
+		}
+		std::stable_sort(keys.begin(), keys.end(), [](const key& a, const key& b) { return a.time < b.time; });
+		const int channel = timeline.add_channel(object, what);
+		for (const auto& k : keys) {
+			timeline.add_key(channel, k.time, k.value, k.mode);
+		}
+	}
+}
+
+bool load_scene_file(const std::string& path, scene_file& out)
+{
+	std::ifstream in(path);
+	if (!in) {
+		std::cerr << "Cannot open scene " << path << std::endl;
+		return false;
+	}
+
+	std::vector<staged_object> objects;
+	std::vector<key> camera_keys[2];
+	out.lights.clear();
+
+	std::string line;
+	for (int line_no = 1; std::getline(in, line); line_no++) {
+		line = line.substr(0, line.find('#'));
+		std::istringstream fields(line);
+		std::string statement;
+		if (!(fields >> statement)) {
+			continue;
+		}
+
+		const auto fail = [&](const char* message) {
+			std::cerr << path << ":" << line_no << ": " << message << std::endl;
+			return false;
+		};
+		staged_object* current = objects.empty() ? nullptr : &objects.back();
+
+		if (statement == "camera") {
+			std::string what;
+			fields >> what;
+			if (what == "fov") {
+				if (!(fields >> out.fov) || out.fov <= 0 || out.fov >= 180) {
+					return fail("expected a field of view between 0 and 180 degrees");
+				}
+			}
+			else if (what == "eye" || what == "target") {
+				if (!read_vec3(fields, what == "eye" ? out.eye : out.target)) {
+					return fail("expected x y z");
+				}
+			}
+			else if (what == "key") {
+				key k{};
+				std::string property;
+				glm::vec3 v;
+				if (!(fields >> k.time >> property) || (property != "eye" && property != "target")
+					|| !read_vec3(fields, v) || !read_mode(fields, k.mode)) {
+					return fail("expected camera key <time> eye|target x y z [step|linear|ease]");
+				}
+				k.value = glm::vec4(v, 0);
+				camera_keys[property == "eye" ? 0 : 1].push_back(k);
+			}
+			else {
+				return fail("expected camera fov, eye, target or key");
+			}
+		}
+		else if (statement == "light") {
+			scene_file::light l;
+			std::string type;
+			fields >> type;
+			if (type == "sun") {
+				if (!read_vec3(fields, l.direction) || glm::length(l.direction) == 0) {
+					return fail("expected light sun x y z [r g b]");
+				}
+			}
+			else if (type == "spot") {
+				glm::vec3 target;
+				if (!read_vec3(fields, l.position) || !read_vec3(fields, target) || !(fields >> l.angle)
+					|| target == l.position || l.angle <= 0 || l.angle >= 170) {
+					return fail("expected light spot x y z x y z degrees [r g b]");
+				}
+				l.type = scene_file::light::kind::spot;
+				l.direction = target - l.position;
+			}
+			else {
+				return fail("expected light sun or light spot");
+			}
+			l.direction = glm::normalize(l.direction);
+			if (!read_optional_vec3(fields, l.color)) {
+				return fail("expected r g b");
+			}
+
+			const auto same = std::count_if(out.lights.begin(), out.lights.end(),
+				[&](const scene_file::light& other) { return other.type == l.type; });
+			if (same >= (l.type == scene_file::light::kind::sun ? 1 : 4)) {
+				return fail("at most one sun and four spot lights");
+			}
+			out.lights.push_back(l);
+		}
+		else if (statement == "ambient") {
+			if (!read_vec3(fields, out.ambient)) {
+				return fail("expected r g b");
+			}
+		}
+		else if (statement == "shadows") {
+			if (!(fields >> out.shadow_size) || out.shadow_size < 64 || out.shadow_size > 8192) {
+				return fail("expected shadows <size 64-8192> [cascades 1-4]");
+			}
+			// The cascades are optional and keep the default without a field.
+			int cascades = out.cascades;
+			if (!read_optional(fields, cascades) || cascades < 1 || cascades > 4) {
+				return fail("expected shadows <size 64-8192> [cascades 1-4]");
+			}
+			out.cascades = cascades;
+		}
+		else if (statement == "object") {
+			objects.emplace_back();
+			auto& mesh = objects.back().data.mesh;
+			// Meshes are found next to the scene file, wherever it is rendered from.
+			if (fields >> mesh && std::filesystem::path(mesh).is_relative()) {
+				mesh = (std::filesystem::path(path).parent_path() / mesh).string();
+			}
+		}
+		else if (current == nullptr) {
+			return fail("statement before the first object");
+		}
+		else if (statement == "position") {
+			if (!read_vec3(fields, current->data.position)) {
+				return fail("expected x y z");
+			}
+		}
+		else if (statement == "rotation") {
+			if (!read_rotation(fields, current->data.rotation)) {
+				return fail("expected axis x y z and degrees");
+			}
+		}
+		else if (statement == "scale") {
+			if (!read_vec3(fields, current->data.scale)) {
+				return fail("expected x y z");
+			}
+		}
+		else if (statement == "spin") {
+			float degrees = 0;
+			if (!read_vec3(fields, current->data.spin_axis) || !(fields >> degrees)
+				|| glm::length(current->data.spin_axis) == 0) {
+				return fail("expected axis x y z and degrees per second");
+			}
+			current->data.spin_speed = glm::radians(degrees);
+		}
+		else if (statement == "key") {
+			key k{};
+			std::string property;
+			if (!(fields >> k.time >> property)) {
+				return fail("expected key <time> position|rotation|scale ...");
+			}
+
+			int channel = 0;
+			glm::vec3 v;
+			if (property == "position" || property == "scale") {
+				if (!read_vec3(fields, v)) {
+					return fail("expected x y z");
+				}
+				k.value = glm::vec4(v, 0);
+				channel = property == "position" ? position_keys : scale_keys;
+			}
+			else if (property == "rotation") {
+				if (!read_rotation(fields, k.value)) {
+					return fail("expected axis x y z and degrees");
+				}
+				channel = rotation_keys;
+			}
+			else {
+				return fail("expected position, rotation or scale");
+			}
+
+			if (!read_mode(fields, k.mode)) {
+				return fail("expected step, linear or ease");
+			}
+			current->keys[channel].push_back(k);
+		}
+		else if (statement == "repeat") {
+			int count = 0;
+			glm::vec3 offset;
+			float delay = 0;
+			if (!(fields >> count) || count < 1 || !read_vec3(fields, offset) || !read_optional(fields, delay)) {
+				return fail("expected repeat <count> x y z [seconds]");
+			}
+
+			const staged_object source = *current;
+			for (int i = 1; i <= count; i++) {
+				staged_object copy = source;
+				const glm::vec3 shift = offset * static_cast<float>(i);
+				copy.data.position += shift;
+				for (auto& keys : copy.keys) {
+					for (auto& k : keys) {
+						k.time += delay * i;
+					}
+				}
+				for (auto& k : copy.keys[position_keys]) {
+					k.value += glm::vec4(shift, 0);
+				}
+				objects.push_back(std::move(copy));
+			}
+		}
+		else {
+			return fail("unknown statement");
+		}
+
+		// Every statement has to use up its line.
+		std::string extra;
+		if (fields >> extra) {
+			return fail("unexpected fields after the statement");
+		}
+	}
+
+	if (objects.empty()) {
+		std::cerr << path << ": no objects" << std::endl;
+		return false;
+	}
+
+	out.objects.clear();
+	out.objects.reserve(objects.size());
+	out.timeline = animation();
+
+	add_keys(out.timeline, animation::camera, animation::property::eye, camera_keys[0]);
+	add_keys(out.timeline, animation::camera, animation::property::target, camera_keys[1]);
+	for (int i = 0; i < static_cast<int>(objects.size()); i++) {
+		out.objects.push_back(objects[i].data);
+		add_keys(out.timeline, i, animation::property::position, objects[i].keys[position_keys]);
+		add_keys(out.timeline, i, animation::property::rotation, objects[i].keys[rotation_keys]);
+		add_keys(out.timeline, i, animation::property::scale, objects[i].keys[scale_keys]);
+	}
+	out.timeline.finish(static_cast<int>(objects.size()));
+
+	return true;
+}
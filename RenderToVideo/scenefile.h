@@ -0,0 +1,71 @@
+#pragma once
+
+#include "animation.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Objects, camera and timeline of a scene, read from a text file so that a new
+// variant does not need a rebuild. One statement per line, # starts a comment:
+//
+//   camera fov 45                      vertical field of view in degrees
+//   camera eye 0 0 3.5                 static camera
+//   camera target 0 0 0
+//   camera key 2 eye 0 2 6 ease        keyframed camera, time in seconds
+//   light sun -1 -2 -1 [1 1 1]         directional light along x y z, with color
+//   light spot 0 4 0 0 0 0 40 [1 1 1]  spot light at x y z aimed at x y z, cone in degrees
+//   ambient 0.2 0.2 0.2                light where no light reaches
+//   shadows 1024 3                     shadow map size and cascades of the sun
+//   object [mesh.rmesh]                starts an object, the cube without a mesh; relative
+//                                      paths are relative to the scene file
+//   position 1 0 0
+//   rotation 0 1 0 45                  axis and degrees
+//   scale 1 1 1
+//   spin 0.5 0.75 0 30                 axis and degrees per second
+//   key 1 position 0 2 0 [step|linear|ease]
+//   key 1 rotation 0 1 0 90
+//   repeat 99 3 0 0 0.1                clones the last object 99 times, each one
+//                                      moved by (3, 0, 0) and 0.1 s later in time
+//
+// Keys apply from their time to the next key of the same property with the
+// interpolation given on the earlier key, linear if none is given. Without
+// lights the objects are drawn with their vertex colors only.
+
+struct scene_file
+{
+	struct object {
+		std::string mesh;		// empty for the built-in cube
+		glm::vec3 position = glm::vec3(0);
+		glm::vec4 rotation = glm::vec4(0, 0, 0, 1);
+		glm::vec3 scale = glm::vec3(1);
+		glm::vec3 spin_axis = glm::vec3(0, 1, 0);
+		float spin_speed = 0;	// radians per second
+	};
+
+	struct light {
+		enum class kind {
+			sun,
+			spot,
+		};
+		kind type = kind::sun;
+		glm::vec3 position = glm::vec3(0);	// spot only
+		glm::vec3 direction = glm::vec3(0, -1, 0);	// the way the light travels
+		glm::vec3 color = glm::vec3(1);
+		float angle = 45.0f;	// full cone in degrees, spot only
+	};
+
+	float fov = 45.0f;
+	glm::vec3 eye = glm::vec3(0, 0, 3.5f);
+	glm::vec3 target = glm::vec3(0);
+	std::vector<object> objects;
+	// At most one sun and four spots.
+	std::vector<light> lights;
+	glm::vec3 ambient = glm::vec3(0.2f);
+	int shadow_size = 1024;
+	int cascades = 3;
+	animation timeline;
+};
+
+[[nodiscard]] bool load_scene_file(const std::string& path, scene_file& out);
@@ -0,0 +1,290 @@
+#include "segments.h"
+#include "platform.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+namespace {
+	// Processes are started from an argument list without a shell, so nothing in the
+	// forwarded arguments is expanded or executed.
+#ifdef _WIN32
+	using process = HANDLE;
+#else
+	using process = pid_t;
+#endif
+
+	std::string command_line(const std::vector<std::string>& args) {
+		std::string line;
+		for (const auto& arg : args) {
+			if (!line.empty()) {
+				line += ' ';
+			}
+			line += quote_argument(arg);
+		}
+		return line;
+	}
+
+	bool start_process(const std::vector<std::string>& args, process& started) {
+		std::cout << "CMD: " << command_line(args) << std::endl;
+#ifdef _WIN32
+		auto line = command_line(args);
+		STARTUPINFOA startup{};
+		startup.cb = sizeof(startup);
+		PROCESS_INFORMATION info{};
+		if (!CreateProcessA(nullptr, line.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info)) {
+			return false;
+		}
+		CloseHandle(info.hThread);
+		started = info.hProcess;
+		return true;
+#else
+		std::vector<char*> argv;
+		for (const auto& arg : args) {
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+		argv.push_back(nullptr);
+		return posix_spawnp(&started, argv[0], nullptr, nullptr, argv.data(), environ) == 0;
+#endif
+	}
+
+	// Waits for the process, true if it exited with 0.
+	bool wait_process(process running) {
+#ifdef _WIN32
+		WaitForSingleObject(running, INFINITE);
+		DWORD code = 1;
+		GetExitCodeProcess(running, &code);
+		CloseHandle(running);
+		return code == 0;
+#else
+		int status = 0;
+		return waitpid(running, &status, 0) == running && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+	}
+
+	bool run_process(const std::vector<std::string>& args) {
+		process running{};
+		return start_process(args, running) && wait_process(running);
+	}
+
+	// A path in a concat list, single quoted with ' written as '\''.
+	std::string concat_quote(const std::string& path) {
+		std::string out = "'";
+		for (char c : path) {
+			if (c == '\'') {
+				out += "'\\''";
+			}
+			else {
+				out += c;
+			}
+		}
+		out += '\'';
+		return out;
+	}
+
+	// The options a worker gets from the coordinator rather than the command line.
+	bool replaced(const char* arg) {
+		return std::strcmp(arg, "--workers") == 0 || std::strcmp(arg, "--first-frame") == 0
+			|| std::strcmp(arg, "--frames") == 0 || std::strcmp(arg, "--output") == 0
+			|| std::strcmp(arg, "--manifest") == 0 || std::strcmp(arg, "--timings") == 0;
+	}
+
+	// <stem>.part<i><extension> next to path.
+	std::string part_path(const std::string& path, int i) {
+		const std::filesystem::path whole(path);
+		auto name = whole.stem();
+		name += ".part" + std::to_string(i);
+		name += whole.extension();
+		return (whole.parent_path() / name).string();
+	}
+
+	bool join_raw(const std::vector<segment>& parts, const std::string& output) {
+		std::ofstream out(output, std::ios::binary | std::ios::trunc);
+		for (const auto& part : parts) {
+			std::ifstream in(part.output, std::ios::binary);
+			if (!in || !(out << in.rdbuf())) {
+				std::cerr << "Cannot append " << part.output << " to " << output << std::endl;
+				return false;
+			}
+		}
+		return static_cast<bool>(out);
+	}
+
+	// Entries in frame order, the header of the first part only.
+	bool join_manifests(const std::vector<segment>& parts, const std::string& manifest) {
+		std::ofstream out(manifest, std::ios::trunc);
+		for (size_t i = 0; i < parts.size(); i++) {
+			std::ifstream in(parts[i].manifest);
+			if (!in) {
+				std::cerr << "Cannot append " << parts[i].manifest << " to " << manifest << std::endl;
+				return false;
+			}
+			std::string line;
+			while (std::getline(in, line)) {
+				if (i == 0 || line.empty() || line[0] != '#') {
+					out << line << "\n";
+				}
+			}
+		}
+		return static_cast<bool>(out);
+	}
+
+	// Rows in frame order, the header line of the first part only.
+	bool join_timings(const std::vector<segment>& parts, const std::string& timings) {
+		std::ofstream out(timings, std::ios::trunc);
+		for (size_t i = 0; i < parts.size(); i++) {
+			std::ifstream in(parts[i].timings);
+			if (!in) {
+				std::cerr << "Cannot append " << parts[i].timings << " to " << timings << std::endl;
+				return false;
+			}
+			std::string line;
+			for (bool header = true; std::getline(in, line); header = false) {
+				if (i == 0 || !header) {
+					out << line << "\n";
+				}
+			}
+		}
+		return static_cast<bool>(out);
+	}
+
+	// The segments start with a key frame and have closed GOPs, so the packets are copied as they are.
+	bool join_encoded(const std::vector<segment>& parts, const std::string& output) {
+		const auto list = std::filesystem::path(output).replace_extension(".segments.txt");
+		{
+			std::ofstream out(list);
+			for (const auto& part : parts) {
+				out << "file " << concat_quote(std::filesystem::absolute(part.output).generic_string()) << std::endl;
+			}
+		}
+
+		const bool joined = run_process({ ffmpeg_executable, "-loglevel", "error", "-y", "-f", "concat",
+			"-safe", "0", "-i", list.string(), "-c", "copy", output });
+		std::filesystem::remove(list);
+		if (!joined) {
+			std::cerr << "Cannot join the segments into " << output << std::endl;
+		}
+		return joined;
+	}
+}
+
+std::vector<segment> split_frames(const options& opts, int workers)
+{
+	const int count = std::max(1, std::min(workers, opts.frames));
+
+	std::vector<segment> parts(count);
+	int first = opts.first_frame;
+	for (int i = 0; i < count; i++) {
+		auto& part = parts[i];
+		part.first_frame = first;
+		part.frames = opts.frames / count + (i < opts.frames % count ? 1 : 0);
+		first += part.frames;
+
+		part.output = opts.output == "null" ? opts.output : part_path(opts.output, i);
+		if (!opts.manifest.empty()) {
+			part.manifest = part_path(opts.manifest, i);
+		}
+		if (!opts.timings.empty()) {
+			part.timings = part_path(opts.timings, i);
+		}
+	}
+	return parts;
+}
+
+bool render_segments(int argc, char** argv, const options& opts)
+{
+	const int workers = opts.workers > 0 ? opts.workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	const auto parts = split_frames(opts, workers);
+
+	// Workers never open a window, whether or not the coordinator was given --headless.
+	std::vector<std::string> common = { argv[0] };
+	for (int i = 1; i < argc; i++) {
+		if (replaced(argv[i])) {
+			i++;
+			continue;
+		}
+		if (std::strcmp(argv[i], "--headless") == 0) {
+			continue;
+		}
+		common.push_back(argv[i]);
+	}
+	common.push_back("--headless");
+
+	const auto started_at = std::chrono::high_resolution_clock::now();
+
+	// All workers run at once.
+	std::vector<process> running(parts.size());
+	std::vector<char> started(parts.size());
+	for (size_t i = 0; i < parts.size(); i++) {
+		const auto& part = parts[i];
+		auto args = common;
+		args.insert(args.end(), { "--first-frame", std::to_string(part.first_frame),
+			"--frames", std::to_string(part.frames), "--output", part.output });
+		if (!part.manifest.empty()) {
+			args.insert(args.end(), { "--manifest", part.manifest });
+		}
+		if (!part.timings.empty()) {
+			args.insert(args.end(), { "--timings", part.timings });
+		}
+		started[i] = start_process(args, running[i]);
+	}
+
+	bool ok = true;
+	for (size_t i = 0; i < running.size(); i++) {
+		if (!started[i] || !wait_process(running[i])) {
+			std::cerr << "Worker for frames " << parts[i].first_frame << " to "
+				<< parts[i].first_frame + parts[i].frames - 1 << " failed" << std::endl;
+			ok = false;
+		}
+	}
+	if (!ok) {
+		return false;
+	}
+
+	const auto rendered_at = std::chrono::high_resolution_clock::now();
+
+	if (opts.output != "null") {
+		const bool raw = std::filesystem::path(opts.output).extension() == ".yuv";
+		if (!(raw ? join_raw(parts, opts.output) : join_encoded(parts, opts.output))) {
+			return false;
+		}
+		for (const auto& part : parts) {
+			std::filesystem::remove(part.output);
+		}
+	}
+	if (!opts.manifest.empty()) {
+		if (!join_manifests(parts, opts.manifest)) {
+			return false;
+		}
+		for (const auto& part : parts) {
+			std::filesystem::remove(part.manifest);
+		}
+	}
+	if (!opts.timings.empty()) {
+		if (!join_timings(parts, opts.timings)) {
+			return false;
+		}
+		for (const auto& part : parts) {
+			std::filesystem::remove(part.timings);
+		}
+	}
+
+	const auto done = std::chrono::high_resolution_clock::now();
+	const double render_s = std::chrono::duration<double>(rendered_at - started_at).count();
+	std::cout << "Segments: " << parts.size() << ", FPS: " << opts.frames / render_s
+		<< ", joining: " << std::chrono::duration<double, std::milli>(done - rendered_at).count() << " ms" << std::endl;
+	return true;
+}
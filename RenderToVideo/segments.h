@@ -0,0 +1,27 @@
+#pragma once
+#include "options.h"
+
+#include <string>
+#include <vector>
+
+// Renders one video as consecutive frame ranges in separate RenderToVideo processes.
+// With deterministic time every frame only depends on its number, so each worker
+// renders and encodes its own segment and the segments are joined without
+// re-encoding: raw .yuv by appending, anything else with the ffmpeg concat demuxer.
+// https://trac.ffmpeg.org/wiki/Concatenate
+
+struct segment {
+	int first_frame = 0;
+	int frames = 0;
+	std::string output;
+	// Empty without --manifest and --timings.
+	std::string manifest;
+	std::string timings;
+};
+
+// Consecutive ranges of about equal length, never an empty one.
+[[nodiscard]] std::vector<segment> split_frames(const options& opts, int workers);
+
+// Starts a worker per segment with the command line of this process, waits for
+// all of them and joins their output into opts.output.
+[[nodiscard]] bool render_segments(int argc, char** argv, const options& opts);
@@ -0,0 +1,413 @@
+#include "shadows.h"
+#include "glprofile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace {
+	const char* depth_vert_source = R"(
+		#version 430 core
+		layout(location = 0) in vec3 pos;
+
+		layout(std430, binding = 0) readonly buffer Models {
+			mat4 model[];
+		};
+
+		uniform mat4 ViewProj;
+		uniform mat4 Decode;
+		uniform int object;
+
+		void main() {
+			gl_Position = ViewProj * model[object] * Decode * vec4(pos, 1);
+		}
+	)";
+
+	const char* depth_frag_source = R"(
+		#version 430 core
+		void main() {
+		}
+	)";
+
+	// Flat shading from the derivatives of the position, meshes have no normals.
+	const char* lit_frag_source = R"(
+		#version 430 core
+		in vec3 fragmentColor;
+		in vec3 worldPosition;
+		out vec3 color;
+
+		uniform vec3 eye;
+		uniform vec3 ambient;
+
+		uniform int cascades;
+		uniform mat4 cascade_matrix[4];
+		uniform sampler2DShadow cascade_map[4];
+		uniform vec3 sun_direction;		// towards the sun
+		uniform vec3 sun_color;
+
+		uniform int spots;
+		uniform mat4 spot_matrix[4];
+		uniform sampler2DShadow spot_map[4];
+		uniform vec3 spot_position[4];
+		uniform vec3 spot_direction[4];
+		uniform vec3 spot_color[4];
+		uniform float spot_cos[4];		// of half the cone
+
+		// Four taps of the 2x2 comparison filter, 4x4 texels.
+		float pcf(sampler2DShadow map, vec3 coord) {
+			vec2 texel = 1.0 / vec2(textureSize(map, 0));
+			float sum = 0;
+			for (int i = 0; i < 4; i++) {
+				vec2 offset = (vec2(i & 1, i >> 1) - 0.5) * texel;
+				sum += textureLod(map, vec3(coord.xy + offset, coord.z), 0);
+			}
+			return sum / 4;
+		}
+
+		void main() {
+			vec3 normal = normalize(cross(dFdx(worldPosition), dFdy(worldPosition)));
+			if (dot(normal, eye - worldPosition) < 0) {
+				normal = -normal;
+			}
+
+			vec3 light = ambient;
+
+			// The nearest cascade that covers the point, a stale one may not.
+			float facing = max(dot(normal, sun_direction), 0);
+			for (int c = 0; c < cascades && facing > 0; c++) {
+				vec3 p = (cascade_matrix[c] * vec4(worldPosition, 1)).xyz;
+				if (all(greaterThan(p, vec3(0.01))) && all(lessThan(p, vec3(0.99)))) {
+					light += sun_color * facing * pcf(cascade_map[c], p);
+					break;
+				}
+				if (c == cascades - 1) {
+					light += sun_color * facing;
+				}
+			}
+
+			for (int s = 0; s < spots; s++) {
+				vec3 to_light = normalize(spot_position[s] - worldPosition);
+				float cone = smoothstep(spot_cos[s], mix(spot_cos[s], 1.0, 0.2), dot(-to_light, spot_direction[s]));
+				float amount = max(dot(normal, to_light), 0) * cone;
+				if (amount > 0) {
+					vec4 p = spot_matrix[s] * vec4(worldPosition, 1);
+					light += spot_color[s] * amount * pcf(spot_map[s], p.xyz / p.w);
+				}
+			}
+
+			color = fragmentColor * light;
+		}
+	)";
+
+	GLuint compile(GLenum type, const char* source) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			GLchar log[512]{};
+			glGetShaderInfoLog(shader, sizeof(log) - 1, nullptr, log);
+			std::cerr << "Shadow shader: " << log << std::endl;
+		}
+		return shader;
+	}
+
+	GLuint depth_only_program() {
+		GLuint vert = compile(GL_VERTEX_SHADER, depth_vert_source);
+		GLuint frag = compile(GL_FRAGMENT_SHADER, depth_frag_source);
+		GLuint prog = glCreateProgram();
+		glAttachShader(prog, vert);
+		glAttachShader(prog, frag);
+		glLinkProgram(prog);
+		glDeleteShader(vert);
+		glDeleteShader(frag);
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(prog, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE) {
+			std::cerr << "Shadow shader: link error" << std::endl;
+			glDeleteProgram(prog);
+			return 0;
+		}
+		return prog;
+	}
+
+	// Location of name[index].
+	GLint element(GLuint program, std::string name, int index) {
+		name += '[';
+		name += std::to_string(index);
+		name += ']';
+		return glGetUniformLocation(program, name.c_str());
+	}
+
+	// Clip space to texture coordinates and depth.
+	glm::mat4 to_texture(const glm::mat4& view_proj) {
+		const glm::mat4 bias = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+		return bias * view_proj;
+	}
+
+	// Any up vector that is not parallel to the direction.
+	glm::vec3 up_for(const glm::vec3& direction) {
+		return std::abs(direction.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+	}
+
+	// Casters this far towards the sun from a cascade still throw shadows into it.
+	constexpr float caster_distance = 50.0f;
+	// Shadows end here even if the camera sees further.
+	constexpr float shadow_distance = 50.0f;
+	constexpr float spot_range = 50.0f;
+	// Blend of logarithmic and uniform cascade splits.
+	constexpr float split_lambda = 0.75f;
+}
+
+shadows::~shadows()
+{
+	Free();
+}
+
+const char* shadows::fragment_source()
+{
+	return lit_frag_source;
+}
+
+bool shadows::init(const scene_file& file, const glm::mat4& proj, GLuint program, const std::vector<char>& moving)
+{
+	if (!maps.empty() || file.lights.empty()) {
+		return false;
+	}
+
+	this->proj = proj;
+	this->moving = moving;
+	any_moving = std::find(moving.begin(), moving.end(), 1) != moving.end();
+	size = file.shadow_size;
+	ambient = file.ambient;
+	lit_program = program;
+
+	for (const auto& light : file.lights) {
+		if (light.type == scene_file::light::kind::sun) {
+			sun = light;
+			cascade_count = file.cascades;
+		}
+		else {
+			spots.push_back(light);
+		}
+	}
+
+	depth_program = depth_only_program();
+	if (depth_program == 0) {
+		return false;
+	}
+	view_proj_location = glGetUniformLocation(depth_program, "ViewProj");
+	decode_location = glGetUniformLocation(depth_program, "Decode");
+	object_location = glGetUniformLocation(depth_program, "object");
+
+	for (int i = 0; i < cascade_count + static_cast<int>(spots.size()); i++) {
+		auto m = std::make_unique<map>();
+		if (!m->cached.init_depth(size, size) || (any_moving && !m->current.init_depth(size, size))) {
+			Free();
+			return false;
+		}
+		maps.push_back(std::move(m));
+	}
+
+	// Spot lights do not move, their matrices are fixed.
+	for (size_t s = 0; s < spots.size(); s++) {
+		const auto& spot = spots[s];
+		const glm::mat4 view = glm::lookAt(spot.position, spot.position + spot.direction, up_for(spot.direction));
+		const glm::mat4 projection = glm::perspective(glm::radians(spot.angle), 1.0f, 0.1f, spot_range);
+		maps[cascade_count + s]->view_proj = projection * view;
+	}
+
+	// Near and far plane of the camera, from its perspective matrix.
+	const float near = proj[3][2] / (proj[2][2] - 1.0f);
+	const float far = std::min(proj[3][2] / (proj[2][2] + 1.0f), shadow_distance);
+	for (int c = 0; c <= cascade_count; c++) {
+		const float f = static_cast<float>(c) / cascade_count;
+		splits[c] = split_lambda * near * std::pow(far / near, f) + (1 - split_lambda) * (near + (far - near) * f);
+	}
+
+	// Samplers never change units: cascades on 0-3, spots on 4-7.
+	for (int i = 0; i < max_cascades; i++) {
+		glProgramUniform1i(lit_program, element(lit_program, "cascade_map", i), i);
+	}
+	for (int i = 0; i < max_spots; i++) {
+		glProgramUniform1i(lit_program, element(lit_program, "spot_map", i), max_cascades + i);
+	}
+
+	const auto location = [&](const char* name) { return glGetUniformLocation(lit_program, name); };
+	lit.eye = location("eye");
+	lit.ambient = location("ambient");
+	lit.cascades = location("cascades");
+	lit.cascade_matrix = location("cascade_matrix");
+	lit.sun_direction = location("sun_direction");
+	lit.sun_color = location("sun_color");
+	lit.spots = location("spots");
+	for (int i = 0; i < max_spots; i++) {
+		lit.spot_matrix[i] = element(lit_program, "spot_matrix", i);
+		lit.spot_position[i] = element(lit_program, "spot_position", i);
+		lit.spot_direction[i] = element(lit_program, "spot_direction", i);
+		lit.spot_color[i] = element(lit_program, "spot_color", i);
+		lit.spot_cos[i] = element(lit_program, "spot_cos", i);
+	}
+	return true;
+}
+
+double shadows::fit_time(int cascade, double time) const
+{
+	if (cascade == 0) {
+		return time;
+	}
+
+	// Cascade i refits on frames 2^(i-1) modulo 2^i, the first frame is everyone's turn.
+	const int64_t period = int64_t(1) << cascade;
+	const int64_t offset = period / 2;
+	const auto frame = static_cast<int64_t>(std::floor(time * fps + 0.5));
+	const int64_t turn = frame - ((frame - offset) % period + period) % period;
+	return static_cast<double>(std::max<int64_t>(turn, 0)) / fps;
+}
+
+void shadows::fit(int cascade, const glm::mat4& view)
+{
+	// Corners of the slice in view space, then a sphere around them so the cascade
+	// keeps its size as the camera turns.
+	const glm::mat4 inverse_view = glm::inverse(view);
+	glm::vec3 corners[8];
+	glm::vec3 center(0);
+	for (int i = 0; i < 8; i++) {
+		const float z = splits[cascade + (i >> 2)];
+		const float x = (i & 1 ? z : -z) / proj[0][0];
+		const float y = (i & 2 ? z : -z) / proj[1][1];
+		corners[i] = glm::vec3(inverse_view * glm::vec4(x, y, -z, 1));
+		center += corners[i] / 8.0f;
+	}
+	float radius = 0;
+	for (const auto& corner : corners) {
+		radius = std::max(radius, glm::length(corner - center));
+	}
+	radius = std::ceil(radius * 16) / 16;
+
+	// Whole texels in light space, so shadow edges do not crawl as the camera moves.
+	const glm::mat4 rotation = glm::lookAt(glm::vec3(0), sun.direction, up_for(sun.direction));
+	glm::vec3 in_light(rotation * glm::vec4(center, 1));
+	const float texel = 2 * radius / size;
+	in_light.x = std::floor(in_light.x / texel) * texel;
+	in_light.y = std::floor(in_light.y / texel) * texel;
+	center = glm::vec3(glm::transpose(rotation) * glm::vec4(in_light, 1));
+
+	const glm::vec3 from = center - sun.direction * (radius + caster_distance);
+	const glm::mat4 light_view = glm::lookAt(from, center, up_for(sun.direction));
+	const glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2 * radius + caster_distance);
+	maps[cascade]->view_proj = projection * light_view;
+}
+
+void shadows::render(scene& world, const std::vector<uint8_t>& lods)
+{
+	counters = stats();
+
+	glUseProgram(depth_program);
+	// Slope scaled bias against acne, casters in front of the near plane are clamped onto it.
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	glEnable(GL_DEPTH_CLAMP);
+
+	for (auto& m : maps) {
+		glUniformMatrix4fv(view_proj_location, 1, GL_FALSE, &m->view_proj[0][0]);
+		const bool refit = !m->valid || m->rendered != m->view_proj;
+		if (refit || any_moving) {
+			world.cull(m->view_proj, casters);
+		}
+
+		if (refit) {
+			m->cached.Begin();
+			glClear(GL_DEPTH_BUFFER_BIT);
+			draw(world, lods, false);
+			m->cached.End();
+			m->rendered = m->view_proj;
+			m->valid = true;
+			counters.static_renders++;
+		}
+
+		m->has_moving = any_moving && std::any_of(casters.begin(), casters.end(),
+			[&](int id) { return moving[id] != 0; });
+		if (m->has_moving) {
+			glCopyImageSubData(m->cached.get_depth_texture(), GL_TEXTURE_2D, 0, 0, 0, 0,
+				m->current.get_depth_texture(), GL_TEXTURE_2D, 0, 0, 0, 0, size, size, 1);
+			m->current.Begin();
+			draw(world, lods, true);
+			m->current.End();
+			counters.moving_renders++;
+		}
+	}
+
+	glDisable(GL_DEPTH_CLAMP);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glUseProgram(0);
+}
+
+void shadows::draw(scene& world, const std::vector<uint8_t>& lods, bool moving_casters)
+{
+	const drawable* decoded = nullptr;
+	for (int id : casters) {
+		if ((moving[id] != 0) != moving_casters) {
+			continue;
+		}
+		auto& mesh = world.mesh(id);
+		if (&mesh != decoded) {
+			const glm::mat4 decode = mesh.decode();
+			glUniformMatrix4fv(decode_location, 1, GL_FALSE, &decode[0][0]);
+			decoded = &mesh;
+		}
+		glUniform1i(object_location, id);
+		mesh.draw(lods[id]);
+		counters.casters++;
+	}
+}
+
+void shadows::bind(const glm::vec3& eye) const
+{
+	glUniform3fv(lit.eye, 1, &eye[0]);
+	glUniform3fv(lit.ambient, 1, &ambient[0]);
+
+	glm::mat4 matrices[max_cascades + max_spots];
+	for (size_t i = 0; i < maps.size(); i++) {
+		const auto& m = *maps[i];
+		matrices[i] = to_texture(m.rendered);
+		glBindTextureUnit(static_cast<GLuint>(i < static_cast<size_t>(cascade_count) ? i : max_cascades + i - cascade_count),
+			m.has_moving ? m.current.get_depth_texture() : m.cached.get_depth_texture());
+	}
+
+	const glm::vec3 towards_sun = -sun.direction;
+	glUniform1i(lit.cascades, cascade_count);
+	glUniformMatrix4fv(lit.cascade_matrix, cascade_count, GL_FALSE, &matrices[0][0][0]);
+	glUniform3fv(lit.sun_direction, 1, &towards_sun[0]);
+	glUniform3fv(lit.sun_color, 1, &sun.color[0]);
+
+	const int spot_count = static_cast<int>(spots.size());
+	glUniform1i(lit.spots, spot_count);
+	for (int s = 0; s < spot_count; s++) {
+		glUniformMatrix4fv(lit.spot_matrix[s], 1, GL_FALSE, &matrices[cascade_count + s][0][0]);
+		glUniform3fv(lit.spot_position[s], 1, &spots[s].position[0]);
+		glUniform3fv(lit.spot_direction[s], 1, &spots[s].direction[0]);
+		glUniform3fv(lit.spot_color[s], 1, &spots[s].color[0]);
+		glUniform1f(lit.spot_cos[s], std::cos(glm::radians(spots[s].angle) / 2));
+	}
+}
+
+void shadows::unbind() const
+{
+	for (GLuint unit = 0; unit < max_cascades + max_spots; unit++) {
+		glBindTextureUnit(unit, 0);
+	}
+}
+
+void shadows::Free()
+{
+	maps.clear();
+	glDeleteProgram(depth_program);
+	depth_program = 0;
+}
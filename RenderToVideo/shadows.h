@@ -0,0 +1,117 @@
+#pragma once
+
+#include "rendertarget.h"
+#include "scene.h"
+#include "scenefile.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Lights of a scene and their shadow maps, depth-only RenderTargets. The sun gets
+// cascades fitted to slices of the view frustum, every spot light one perspective map.
+//
+// Objects that never move are cached: each map keeps a target with only the static
+// casters, drawn again when the light matrix of the map changes, and the moving
+// casters are drawn over a copy of it every frame. Cascade 0 is refit every frame,
+// cascade i every 2^i frames on frames no other cascade i > 0 uses, so at most two
+// cascades move per frame. The schedule follows the animation time, so a segment
+// rendered on its own gets the same maps as the whole video.
+// https://learn.microsoft.com/en-us/windows/win32/dxtecharticle/cascaded-shadow-maps
+
+class shadows
+{
+public:
+	enum constants {
+		max_cascades = 4,
+		max_spots = 4,
+	};
+
+	struct stats {
+		int static_renders = 0;		// maps whose static casters were drawn again
+		int moving_renders = 0;		// maps with moving casters drawn over the cache
+		int casters = 0;			// objects drawn into maps
+	};
+
+	virtual ~shadows();
+
+	// Fragment shader of the lit program, reads the worldPosition and fragmentColor outputs.
+	static const char* fragment_source();
+
+	// program is the lit program bind() sets the uniforms of, moving flags every object
+	// that is animated and never cached.
+	[[nodiscard]] bool init(const scene_file& file, const glm::mat4& proj, GLuint program,
+		const std::vector<char>& moving);
+	[[nodiscard]] bool enabled() const { return !maps.empty(); }
+	[[nodiscard]] int cascades() const { return cascade_count; }
+	void set_frame_rate(int fps) { this->fps = fps; }
+
+	// Time the camera has to be sampled at to fit cascade for the frame at time.
+	[[nodiscard]] double fit_time(int cascade, double time) const;
+	// Fits cascade to its slice of the frustum seen through view.
+	void fit(int cascade, const glm::mat4& view);
+
+	// Draws the casters into every map that needs it, the model matrices bound to binding 0.
+	void render(scene& world, const std::vector<uint8_t>& lods);
+
+	// Uniforms and maps of the lit program, on texture units 0 to 7.
+	void bind(const glm::vec3& eye) const;
+	void unbind() const;
+
+	[[nodiscard]] const stats& get_stats() const { return counters; }
+
+private:
+	struct map {
+		RenderTarget cached;	// static casters only
+		RenderTarget current;	// the cache plus moving casters, only with moving objects
+		glm::mat4 view_proj = glm::mat4(1.0f);
+		glm::mat4 rendered = glm::mat4(1.0f);	// view_proj of the cache
+		bool valid = false;
+		bool has_moving = false;	// current holds this frame's moving casters
+	};
+
+	// Uniforms of the lit program bind() sets, looked up once in init().
+	struct lit_locations {
+		GLint eye = -1;
+		GLint ambient = -1;
+		GLint cascades = -1;
+		GLint cascade_matrix = -1;
+		GLint sun_direction = -1;
+		GLint sun_color = -1;
+		GLint spots = -1;
+		GLint spot_matrix[max_spots]{};
+		GLint spot_position[max_spots]{};
+		GLint spot_direction[max_spots]{};
+		GLint spot_color[max_spots]{};
+		GLint spot_cos[max_spots]{};
+	};
+
+	void draw(scene& world, const std::vector<uint8_t>& lods, bool moving_casters);
+	void Free();
+
+private:
+	std::vector<std::unique_ptr<map>> maps;		// cascades first, then spots
+	std::vector<scene_file::light> spots;
+	scene_file::light sun;
+	glm::vec3 ambient = glm::vec3(0);
+	glm::mat4 proj = glm::mat4(1.0f);
+	float splits[max_cascades + 1]{};
+	int cascade_count = 0;
+	int size = 0;
+	int fps = 30;
+	std::vector<char> moving;
+	bool any_moving = false;
+	std::vector<int> casters;
+
+	GLuint depth_program = 0;
+	GLint view_proj_location = -1;
+	GLint decode_location = -1;
+	GLint object_location = -1;
+	GLuint lit_program = 0;
+	lit_locations lit;
+
+	stats counters;
+};
@@ -0,0 +1,96 @@
+#include "sink.h"
+#include "framestore.h"
+#include "platform.h"
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+file_sink::~file_sink()
+{
+	if (file != nullptr) {
+		fclose(file);
+	}
+}
+
+bool file_sink::init(const std::string& filename)
+{
+	if (file != nullptr) {
+		return false;
+	}
+
+	file = fopen(filename.c_str(), "wb");
+	return file != nullptr;
+}
+
+bool file_sink::write(const unsigned char* data, size_t size)
+{
+	return write_unlocked(data, size, file) == size;
+}
+
+ffmpeg_sink::~ffmpeg_sink()
+{
+	if (pipe != nullptr) {
+		close_pipe(pipe);
+	}
+}
+
+bool ffmpeg_sink::init(const std::string& filename, int width, int height, int fps, const std::string& codec)
+{
+	if (pipe != nullptr) {
+		return false;
+	}
+
+	std::stringstream ss;
+	ss << ffmpeg_executable << " -loglevel error "
+		<< "-f rawvideo -pixel_format yuv420p -video_size "
+		<< width << "*" << height << " -framerate " << fps << " -i - "
+		// Closed GOPs so that separately encoded segments can be joined without re-encoding.
+		<< "-c:v " << quote_argument(codec) << " -flags +cgop " << quote_argument(filename);
+
+	auto cmd = ss.str();
+	std::cout << "CMD: " << cmd << std::endl;
+	pipe = open_pipe(cmd.c_str());
+	return pipe != nullptr;
+}
+
+bool ffmpeg_sink::write(const unsigned char* data, size_t size)
+{
+	return write_unlocked(data, size, pipe) == size;
+}
+
+std::unique_ptr<sink> open_sink(const std::string& filename, int width, int height, int fps, const std::string& codec,
+	int first_frame, int frames)
+{
+	if (filename == "null") {
+		return std::make_unique<null_sink>();
+	}
+
+	if (std::filesystem::exists(filename)) {
+		std::filesystem::remove(filename);
+	}
+
+	if (std::filesystem::path(filename).extension() == ".yuv") {
+		auto out = std::make_unique<file_sink>();
+		if (!out->init(filename)) {
+			std::cerr << "Cannot open " << filename << std::endl;
+			return nullptr;
+		}
+		return out;
+	}
+
+	if (std::filesystem::path(filename).extension() == ".frames") {
+		auto out = std::make_unique<frame_store>();
+		if (!out->init(filename, width, height, fps, first_frame, frames)) {
+			return nullptr;
+		}
+		return out;
+	}
+
+	auto out = std::make_unique<ffmpeg_sink>();
+	if (!out->init(filename, width, height, fps, codec)) {
+		std::cerr << "Cannot start ffmpeg for " << filename << std::endl;
+		return nullptr;
+	}
+	return out;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Destination of encoded I420 frames.
+
+class sink
+{
+public:
+	virtual ~sink() = default;
+	virtual bool write(const unsigned char* data, size_t size) = 0;
+};
+
+// Discards every frame, measures the pipeline without output cost.
+class null_sink : public sink
+{
+public:
+	bool write(const unsigned char*, size_t) override { return true; }
+};
+
+// Raw I420 frames appended to a file.
+class file_sink : public sink
+{
+public:
+	~file_sink() override;
+	[[nodiscard]] bool init(const std::string& filename);
+	bool write(const unsigned char* data, size_t size) override;
+
+private:
+	FILE* file = nullptr;
+};
+
+// Frames piped to an ffmpeg process that encodes them.
+class ffmpeg_sink : public sink
+{
+public:
+	~ffmpeg_sink() override;
+	[[nodiscard]] bool init(const std::string& filename, int width, int height, int fps, const std::string& codec);
+	bool write(const unsigned char* data, size_t size) override;
+
+private:
+	FILE* pipe = nullptr;
+};
+
+// "null" discards, a .yuv extension writes raw frames, .frames a frame_store, anything else is encoded.
+// frames preallocates a frame store, 0 if the length is not known.
+[[nodiscard]] std::unique_ptr<sink> open_sink(const std::string& filename, int width, int height,
+	int fps, const std::string& codec, int first_frame = 0, int frames = 0);
@@ -0,0 +1,84 @@
+#include "transforms.h"
+
+#include <cmath>
+
+int transforms::add(const glm::vec3& position, const glm::vec4& rotation, const glm::vec3& scale)
+{
+	pos_x.push_back(position.x);
+	pos_y.push_back(position.y);
+	pos_z.push_back(position.z);
+	rot_x.push_back(rotation.x);
+	rot_y.push_back(rotation.y);
+	rot_z.push_back(rotation.z);
+	rot_w.push_back(rotation.w);
+	scale_x.push_back(scale.x);
+	scale_y.push_back(scale.y);
+	scale_z.push_back(scale.z);
+	spin_x.push_back(0);
+	spin_y.push_back(1);
+	spin_z.push_back(0);
+	spin_speed.push_back(0);
+	return size() - 1;
+}
+
+void transforms::set_position(int id, const glm::vec3& position)
+{
+	pos_x[id] = position.x;
+	pos_y[id] = position.y;
+	pos_z[id] = position.z;
+}
+
+void transforms::set_rotation(int id, const glm::vec4& rotation)
+{
+	rot_x[id] = rotation.x;
+	rot_y[id] = rotation.y;
+	rot_z[id] = rotation.z;
+	rot_w[id] = rotation.w;
+}
+
+void transforms::set_scale(int id, const glm::vec3& scale)
+{
+	scale_x[id] = scale.x;
+	scale_y[id] = scale.y;
+	scale_z[id] = scale.z;
+}
+
+void transforms::set_spin(int id, const glm::vec3& axis, float speed)
+{
+	const glm::vec3 unit = glm::normalize(axis);
+	spin_x[id] = unit.x;
+	spin_y[id] = unit.y;
+	spin_z[id] = unit.z;
+	spin_speed[id] = speed;
+}
+
+void transforms::evaluate(double time, int begin, int end, glm::mat4* out) const
+{
+	for (int i = begin; i < end; i++) {
+		// Spin quaternion, angle reduced in double so long renders keep their precision.
+		const double angle = std::fmod(static_cast<double>(spin_speed[i]) * time, 2 * 3.14159265358979323846);
+		const float s = static_cast<float>(std::sin(angle / 2));
+		const float sw = static_cast<float>(std::cos(angle / 2));
+		const float sx = spin_x[i] * s;
+		const float sy = spin_y[i] * s;
+		const float sz = spin_z[i] * s;
+
+		// q = spin * rotation
+		const float rx = rot_x[i], ry = rot_y[i], rz = rot_z[i], rw = rot_w[i];
+		const float x = sw * rx + sx * rw + sy * rz - sz * ry;
+		const float y = sw * ry - sx * rz + sy * rw + sz * rx;
+		const float z = sw * rz + sx * ry - sy * rx + sz * rw;
+		const float w = sw * rw - sx * rx - sy * ry - sz * rz;
+
+		// Translation * rotation * scale, written column by column.
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+
+		glm::mat4& m = out[i];
+		m[0] = glm::vec4(1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0) * scale_x[i];
+		m[1] = glm::vec4(2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0) * scale_y[i];
+		m[2] = glm::vec4(2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0) * scale_z[i];
+		m[3] = glm::vec4(pos_x[i], pos_y[i], pos_z[i], 1);
+	}
+}
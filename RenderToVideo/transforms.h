@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Object transforms as a structure of arrays: position, rotation as a quaternion and
+// scale, plus a spin around a fixed axis. Matrices are evaluated from absolute time, so
+// nothing accumulates from frame to frame and any range can be evaluated independently.
+
+class transforms
+{
+public:
+	int add(const glm::vec3& position, const glm::vec4& rotation = glm::vec4(0, 0, 0, 1),
+		const glm::vec3& scale = glm::vec3(1));
+
+	void set_position(int id, const glm::vec3& position);
+	void set_rotation(int id, const glm::vec4& rotation);
+	void set_scale(int id, const glm::vec3& scale);
+	// Spin around axis at speed radians per second, applied on top of the rotation.
+	void set_spin(int id, const glm::vec3& axis, float speed);
+
+	// Writes the world matrices of objects [begin, end) at time into out[begin, end).
+	void evaluate(double time, int begin, int end, glm::mat4* out) const;
+
+	[[nodiscard]] int size() const { return static_cast<int>(pos_x.size()); }
+
+private:
+	std::vector<float> pos_x, pos_y, pos_z;
+	// Quaternion x, y, z, w.
+	std::vector<float> rot_x, rot_y, rot_z, rot_w;
+	std::vector<float> scale_x, scale_y, scale_z;
+	// Unit axis and angular speed.
+	std::vector<float> spin_x, spin_y, spin_z, spin_speed;
+};
@@ -0,0 +1,177 @@
+#include "videosource.h"
+#include "glprofile.h"
+#include "platform.h"
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+video_source::~video_source()
+{
+	Free();
+}
+
+bool video_source::init(const std::string& input, GLsizei width, GLsizei height, format fmt, int depth)
+{
+	if (file != nullptr || depth < 1 || width % 2 != 0 || height % 2 != 0) {
+		return false;
+	}
+
+	const auto extension = std::filesystem::path(input).extension();
+	if (input == "-") {
+		file = binary_stdin();
+	}
+	else if (extension == ".yuv" || extension == ".nv12") {
+		file = fopen(input.c_str(), "rb");
+	}
+	else {
+		std::stringstream ss;
+		ss << ffmpeg_executable << " -loglevel error -i " << quote_argument(input) << " "
+			<< "-f rawvideo -pix_fmt " << (fmt == format::nv12 ? "nv12" : "yuv420p")
+			<< " -vf scale=" << width << ":" << height << " -";
+
+		const auto cmd = ss.str();
+		std::cout << "CMD: " << cmd << std::endl;
+		file = open_read_pipe(cmd.c_str());
+		pipe = true;
+	}
+
+	if (file == nullptr) {
+		std::cerr << "Cannot open input " << input << std::endl;
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->fmt = fmt;
+	y_size = static_cast<size_t>(width) * height;
+	frame_size = y_size + y_size / 2;
+
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	slots.resize(depth);
+	for (auto& s : slots) {
+		glCreateBuffers(1, &s.pbo);
+		glNamedBufferStorage(s.pbo, static_cast<GLsizeiptr>(frame_size), nullptr, flags);
+		s.data = static_cast<unsigned char*>(
+			glMapNamedBufferRange(s.pbo, 0, static_cast<GLsizeiptr>(frame_size), flags));
+		if (s.data == nullptr) {
+			std::cerr << "Cannot map input buffer" << std::endl;
+			return false;
+		}
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, fmt == format::nv12 ? 2 : 3, tex);
+	glTextureStorage2D(tex[0], 1, GL_R8, width, height);
+	if (fmt == format::nv12) {
+		glTextureStorage2D(tex[1], 1, GL_RG8, width / 2, height / 2);
+	}
+	else {
+		glTextureStorage2D(tex[1], 1, GL_R8, width / 2, height / 2);
+		glTextureStorage2D(tex[2], 1, GL_R8, width / 2, height / 2);
+	}
+
+	for (GLuint t : tex) {
+		if (t == 0) {
+			continue;
+		}
+		// Linear filtering upsamples the chroma planes.
+		glTextureParameteri(t, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(t, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(t, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(t, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	read(slots[head]);
+	return true;
+}
+
+void video_source::upload()
+{
+	auto& s = slots[head];
+	if (!s.filled) {
+		return;
+	}
+
+	// Rows are uploaded in file order, so the first row of the input ends up
+	// at texture row 0 where readback also starts.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.pbo);
+	glTextureSubImage2D(tex[0], 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+	if (fmt == format::nv12) {
+		glTextureSubImage2D(tex[1], 0, 0, 0, width / 2, height / 2, GL_RG, GL_UNSIGNED_BYTE,
+			reinterpret_cast<void*>(y_size));
+	}
+	else {
+		for (int plane = 1; plane < planes; plane++) {
+			glTextureSubImage2D(tex[plane], 0, 0, 0, width / 2, height / 2, GL_RED, GL_UNSIGNED_BYTE,
+				reinterpret_cast<void*>(y_size + (plane - 1) * y_size / 4));
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s.filled = false;
+	counters.frames++;
+
+	head = (head + 1) % static_cast<int>(slots.size());
+}
+
+void video_source::read_next()
+{
+	if (slots[head].filled) {
+		return;
+	}
+	// Start the submitted frame before blocking on the input.
+	glFlush();
+	read(slots[head]);
+}
+
+void video_source::read(slot& s)
+{
+	// The buffer may still be the source of an upload from depth frames ago.
+	if (s.fence != nullptr) {
+		const auto wait_start = clock::now();
+		if (glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED) == GL_WAIT_FAILED) {
+			std::cerr << "Input: fence wait failed" << std::endl;
+		}
+		glDeleteSync(s.fence);
+		s.fence = nullptr;
+		counters.wait_ms += std::chrono::duration<double, std::milli>(clock::now() - wait_start).count();
+	}
+
+	const auto read_start = clock::now();
+	const size_t got = read_unlocked(s.data, frame_size, file);
+	counters.read_ms += std::chrono::duration<double, std::milli>(clock::now() - read_start).count();
+
+	s.filled = got == frame_size;
+	if (got != 0 && got != frame_size) {
+		std::cerr << "Input: incomplete frame after " << counters.frames << " frames" << std::endl;
+	}
+}
+
+void video_source::Free()
+{
+	for (auto& s : slots) {
+		if (s.fence != nullptr) {
+			glDeleteSync(s.fence);
+		}
+		if (s.data != nullptr) {
+			glUnmapNamedBuffer(s.pbo);
+		}
+		glDeleteBuffers(1, &s.pbo);
+	}
+	slots.clear();
+
+	for (GLuint& t : tex) {
+		glDeleteTextures(1, &t);
+		t = 0;
+	}
+
+	if (pipe) {
+		close_pipe(file);
+	}
+	else if (file != nullptr && file != stdin) {
+		fclose(file);
+	}
+	file = nullptr;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Raw video frames coming in, the mirror image of readback. Frames are read
+// from a file, stdin or an ffmpeg decoder straight into a ring of persistently
+// mapped pixel unpack buffers and uploaded from there into R8 plane textures
+// (RG8 for the interleaved chroma of NV12). The next frame is read while the
+// GPU still works on the current one.
+// https://www.songho.ca/opengl/gl_pbo.html#unpack
+
+class video_source
+{
+public:
+	enum class format {
+		i420,	// Y, then U and V at quarter size
+		nv12,	// Y, then interleaved UV at quarter size
+	};
+
+	struct stats {
+		int frames = 0;
+		double read_ms = 0;		// total time reading input
+		double wait_ms = 0;		// total time blocked on fences
+	};
+
+	virtual ~video_source();
+
+	// A .yuv or .nv12 file is read as is, "-" reads stdin, anything else is
+	// decoded and scaled to the given size by ffmpeg.
+	[[nodiscard]] bool init(const std::string& input, GLsizei width, GLsizei height, format fmt, int depth = 2);
+
+	// True while a frame has been read and waits to be uploaded.
+	[[nodiscard]] bool ready() const { return slots[head].filled; }
+	// Upload the waiting frame into the plane textures.
+	void upload();
+	// Reads the next frame into the following slot. Call it after the frame that uploads
+	// the current one has been submitted, so the GPU renders while the input is read.
+	void read_next();
+
+	// Luma, then chroma. Plane 2 is 0 for NV12, both chroma channels are in plane 1.
+	[[nodiscard]] GLuint get_texture(int plane) const { return tex[plane]; }
+	[[nodiscard]] const stats& get_stats() const { return counters; }
+
+private:
+	struct slot {
+		GLuint pbo = 0;
+		unsigned char* data = nullptr;
+		GLsync fence = nullptr;
+		bool filled = false;
+	};
+
+	void read(slot& s);
+	void Free();
+
+	using clock = std::chrono::high_resolution_clock;
+
+	enum constants {
+		planes = 3
+	};
+
+private:
+	FILE* file = nullptr;
+	bool pipe = false;
+	GLsizei width = 0;
+	GLsizei height = 0;
+	format fmt = format::i420;
+	size_t y_size = 0;
+	size_t frame_size = 0;
+	std::vector<slot> slots;
+	int head = 0;
+	GLuint tex[planes]{};
+	stats counters;
+};
@@ -1,4 +1,5 @@
 #include "yuv.h"
+#include "glprofile.h"
 
 #include <iostream>
 
@@ -52,7 +53,7 @@ namespace {
 
             mat4 toYUV = mat4( 0.299, -0.14713,  0.615,   0,
                                0.587, -0.28886, -0.51499, 0,
-                               0.144,  0.436,   -0.10001, 0,
+                               0.114,  0.436,   -0.10001, 0,
                                0.0625, 0.5,      0.5,     1 );
 
 			void main() {
@@ -93,13 +94,6 @@ namespace {
 
 		return prog;
 	}
-
-	void checkError() {
-		auto err = glGetError();
-		if (err != 0) {
-			std::cerr << "GL error: " << err << std::endl;
-		}
-	}
 }
 
 yuv::~yuv()
@@ -118,7 +112,6 @@ bool yuv::init(GLsizei width, GLsizei height)
 
 	glGenFramebuffers(1, &fbo);
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-	checkError();
 
 	glGenTextures(channels, &tex[0]);
 
@@ -127,10 +120,8 @@ bool yuv::init(GLsizei width, GLsizei height)
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height,
 			0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
 
-		checkError();
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		checkError();
 	}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
@@ -141,16 +132,13 @@ bool yuv::init(GLsizei width, GLsizei height)
 		width, height);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 
 		GL_RENDERBUFFER, depth);
-	checkError();
 
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex[0], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, tex[1], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, tex[2], 0);
-	checkError();
 
 	GLenum DrawBuffers[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
 	glDrawBuffers(channels, DrawBuffers);
-	checkError();
 
 	auto status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
 
@@ -195,9 +183,7 @@ void yuv::RenderTexture(int width, int height, int channel)
 {
 	glViewport(0, 0, width, height);
 	
-	checkError();
 	glUseProgram(program_id);
-	checkError();
 	GLuint texLoc = glGetUniformLocation(program_id, "tex0");
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, channel);
@@ -230,17 +216,14 @@ bool yuv::InitTextureToScreen()
 	// The fullscreen quad's FBO
 	glGenVertexArrays(1, &quad_vert_arr_id);
 	glBindVertexArray(quad_vert_arr_id);
-	checkError();
 
 	glGenBuffers(1, &quad_vert_buffer_id);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vert_buffer_id);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertex_buffer_data), quad_vertex_buffer_data, GL_STATIC_DRAW);
-	checkError();
 
 	glEnableVertexAttribArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vert_buffer_id);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-	checkError();
 
 	glBindVertexArray(0);
 
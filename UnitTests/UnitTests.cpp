@@ -0,0 +1,329 @@
+// Unit tests of the modules that do their work on the CPU: the BVH, frustum culling,
+// animation sampling, frame graph scheduling, the frame store and the simplifier.
+// Only the frame graph needs a GL context, for the render targets it allocates.
+
+#include "animation.h"
+#include "bvh.h"
+#include "framegraph.h"
+#include "framestore.h"
+#include "frustum.h"
+#include "golden.h"
+#include "simplify.h"
+#include "transforms.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const char* test, const char* what) {
+		if (!condition) {
+			std::cerr << test << ": " << what << std::endl;
+			failures++;
+		}
+	}
+
+	bool contains(const aabb& outer, const aabb& inner) {
+		for (int i = 0; i < 3; i++) {
+			if (inner.min[i] < outer.min[i] || inner.max[i] > outer.max[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<aabb> random_boxes(std::mt19937& rng, int count, float spread) {
+		std::uniform_real_distribution<float> pos(-spread, spread);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+		std::vector<aabb> boxes(count);
+		for (auto& box : boxes) {
+			box.min = glm::vec3(pos(rng), pos(rng), pos(rng));
+			box.max = box.min + glm::vec3(size(rng), size(rng), size(rng));
+		}
+		return boxes;
+	}
+
+	// Every node bounds the boxes in its range, and the leaf order is a permutation.
+	bool bvh_valid(const bvh& tree, const std::vector<aabb>& boxes) {
+		const auto& order = tree.order();
+		const auto& positions = tree.positions();
+		for (int i = 0; i < static_cast<int>(order.size()); i++) {
+			if (positions[order[i]] != i) {
+				return false;
+			}
+		}
+		for (const auto& n : tree.nodes()) {
+			if (n.leaf() && n.count > bvh::leaf_size) {
+				return false;
+			}
+			for (int i = n.first; i < n.first + n.count; i++) {
+				if (!contains(n.bounds, boxes[order[i]])) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void test_bvh() {
+		std::mt19937 rng(1);
+		auto boxes = random_boxes(rng, 1000, 50);
+
+		bvh tree;
+		tree.build(boxes);
+		check(bvh_valid(tree, boxes), "bvh", "built tree does not bound its boxes");
+		check(tree.nodes().front().count == 1000, "bvh", "root does not hold every box");
+
+		std::vector<int> moved;
+		for (int i = 0; i < 1000; i += 7) {
+			boxes[i].min += glm::vec3(3, -2, 1);
+			boxes[i].max += glm::vec3(3, -2, 1);
+			moved.push_back(i);
+		}
+		tree.refit(boxes, moved);
+		check(bvh_valid(tree, boxes), "bvh", "refitted tree does not bound the moved boxes");
+		check(!tree.degraded(), "bvh", "small moves degraded the tree");
+
+		for (int i : moved) {
+			boxes[i].min *= 20.0f;
+			boxes[i].max = boxes[i].min + glm::vec3(1);
+		}
+		tree.refit(boxes, moved);
+		check(bvh_valid(tree, boxes), "bvh", "refitted tree does not bound the scattered boxes");
+		check(tree.degraded(), "bvh", "scattering the boxes did not degrade the tree");
+	}
+
+	// cull() takes the AVX2 kernel for full groups of eight when the CPU has it and
+	// the scalar loop for the rest; both have to agree with test() on every box.
+	void test_culling() {
+		std::mt19937 rng(2);
+		const int count = 1003;
+		const auto boxes = random_boxes(rng, count, 60);
+		aabb_soa soa;
+		soa.resize(count);
+		for (int i = 0; i < count; i++) {
+			soa.set(i, boxes[i]);
+		}
+
+		const glm::mat4 view_proj = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 100.0f)
+			* glm::lookAt(glm::vec3(0, 0, 30), glm::vec3(0), glm::vec3(0, 1, 0));
+		const frustum f(view_proj);
+
+		std::vector<int> expected;
+		for (int i = 0; i < count; i++) {
+			if (f.test(boxes[i]) != frustum::result::outside) {
+				expected.push_back(i);
+			}
+		}
+		check(!expected.empty() && static_cast<int>(expected.size()) < count, "culling", "no box is both in and out");
+
+		// Unaligned starts and lengths mix both paths.
+		for (int first : { 0, 3, 8 }) {
+			std::vector<int> visible(count);
+			const int n = f.cull(soa, first, count - first, visible.data());
+			visible.resize(n);
+			std::vector<int> want;
+			std::copy_if(expected.begin(), expected.end(), std::back_inserter(want), [&](int i) { return i >= first; });
+			check(visible == want, "culling", "batched culling differs from the single box test");
+		}
+	}
+
+	glm::vec3 camera_eye(animation& a, double time) {
+		glm::vec3 eye(0), target(0);
+		a.sample_camera(time, eye, target);
+		return eye;
+	}
+
+	animation make_timeline() {
+		animation a;
+		const int eye = a.add_channel(animation::camera, animation::property::eye);
+		a.add_key(eye, 0, glm::vec4(0, 0, 0, 0));
+		a.add_key(eye, 1, glm::vec4(10, 0, 0, 0), animation::interpolation::step);
+		a.add_key(eye, 2, glm::vec4(20, 0, 0, 0), animation::interpolation::ease);
+		a.add_key(eye, 4, glm::vec4(0, 20, 0, 0));
+		const int position = a.add_channel(0, animation::property::position);
+		a.add_key(position, 1, glm::vec4(0, 0, 0, 0));
+		a.add_key(position, 3, glm::vec4(0, 6, 0, 0));
+		a.finish(1);
+		return a;
+	}
+
+	void test_animation() {
+		auto a = make_timeline();
+		const auto near = [](const glm::vec3& x, const glm::vec3& y) { return glm::length(x - y) < 1e-4f; };
+
+		check(near(camera_eye(a, -1), glm::vec3(0)), "animation", "before the first key");
+		check(near(camera_eye(a, 0.5), glm::vec3(5, 0, 0)), "animation", "linear key");
+		check(near(camera_eye(a, 1.5), glm::vec3(10, 0, 0)), "animation", "step key");
+		check(near(camera_eye(a, 3), glm::vec3(10, 10, 0)), "animation", "ease key at its midpoint");
+		check(near(camera_eye(a, 9), glm::vec3(0, 20, 0)), "animation", "after the last key");
+
+		transforms objects;
+		objects.add(glm::vec3(0));
+		a.sample(2, 0, 1, objects);
+		glm::mat4 world;
+		objects.evaluate(2, 0, 1, &world);
+		check(near(glm::vec3(world[3]), glm::vec3(0, 3, 0)), "animation", "object position");
+
+		// The cursors remember the last key: forward steps, jumps back and jumps ahead
+		// must sample the same as a timeline that has never been sampled.
+		const double times[] = { 0, 0.1, 0.2, 1.1, 3.9, 0.3, 2.5, 2.6, -1, 5, 1.0, 2.0 };
+		for (double t : times) {
+			auto fresh = make_timeline();
+			check(near(camera_eye(a, t), camera_eye(fresh, t)), "animation", "cursor sampled another key");
+		}
+
+		check(a.changes(0.5, 0.6), "animation", "moving channel not seen as changing");
+		check(!a.changes(5, 6), "animation", "channels past their last key seen as changing");
+		check(!a.changes(-2, -1), "animation", "channels before their first key seen as changing");
+	}
+
+	void test_framegraph() {
+		framegraph graph;
+		const auto scene = graph.create_target("scene", 64, 64);
+		const auto blur = graph.create_target("blur", 64, 64);
+		const auto unused = graph.create_target("unused", 64, 64);
+		const auto tone = graph.create_target("tone", 64, 64);
+		const auto window = graph.import("window");
+		graph.mark_output(window);
+
+		std::vector<std::string> ran;
+		const auto record = [&](const char* name) { return [&ran, name](const framegraph::registry&) { ran.push_back(name); }; };
+		using access = framegraph::access;
+		// Declared out of order: the graph has to run producers first.
+		graph.add_pass("present", { { tone, access::sampled } }, { { window, access::attachment } }, record("present"));
+		graph.add_pass("tone", { { blur, access::sampled } }, { { tone, access::attachment } }, record("tone"));
+		graph.add_pass("scene", {}, { { scene, access::attachment } }, record("scene"));
+		graph.add_pass("debug", { { scene, access::sampled } }, { { unused, access::attachment } }, record("debug"));
+		graph.add_pass("blur", { { scene, access::sampled } }, { { blur, access::attachment } }, record("blur"));
+
+		check(graph.compile(), "framegraph", "compile failed");
+		graph.execute();
+		const auto& stats = graph.get_stats();
+		check(stats.culled == 1, "framegraph", "the pass nothing reads was not culled");
+		check(ran == std::vector<std::string>{ "scene", "blur", "tone", "present" }, "framegraph", "passes ran out of order");
+		// scene dies when blur is written, so tone can take its target.
+		check(stats.transient == 3 && stats.physical == 2, "framegraph", "transient targets were not aliased");
+	}
+
+	void test_frame_store() {
+		const std::string path = "unit_tests.frames";
+		constexpr int width = 16;
+		constexpr int height = 8;
+		constexpr size_t size = width * height * 3 / 2;
+		std::vector<unsigned char> frames[3];
+		for (int i = 0; i < 3; i++) {
+			frames[i].assign(size, static_cast<unsigned char>(40 * i + 1));
+		}
+
+		uint64_t data_offset = 0;
+		{
+			frame_store store;
+			check(store.init(path, width, height, 30, 5, 4), "frame store", "create failed");
+			for (const auto& f : frames) {
+				store.write(f.data(), f.size());
+			}
+			data_offset = store.info().data_offset;
+		}
+
+		// A frame that did not fully reach the disk ends the store there.
+		{
+			std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(static_cast<std::streamoff>(data_offset + size + 10));
+			file.put(static_cast<char>(0xFF));
+		}
+
+		frame_store store;
+		check(store.init(path), "frame store", "reopen failed");
+		check(store.frames() == 1 && store.info().first_frame == 5, "frame store", "resume did not stop at the damaged frame");
+		store.write(frames[2].data(), frames[2].size());
+		check(store.frames() == 2 && std::equal(frames[2].begin(), frames[2].end(), store.frame(1)),
+			"frame store", "resumed frame not appended after the kept ones");
+		check(hash_frame(store.frame(0), size) == hash_frame(frames[0].data(), size), "frame store", "kept frame changed");
+	}
+
+	void test_simplifier() {
+		// A flat grid: every collapse is free, down to two triangles.
+		constexpr int n = 16;
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		for (int y = 0; y <= n; y++) {
+			for (int x = 0; x <= n; x++) {
+				positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+			}
+		}
+		for (int y = 0; y < n; y++) {
+			for (int x = 0; x < n; x++) {
+				const uint32_t v = y * (n + 1) + x;
+				indices.insert(indices.end(), { v, v + 1, v + n + 2, v, v + n + 2, v + n + 1 });
+			}
+		}
+
+		simplifier s(positions, indices);
+		const size_t left = s.simplify(n * n);
+		check(left <= n * n, "simplifier", "more triangles than asked for");
+		check(s.error() < 1e-4f, "simplifier", "a flat grid gained error");
+		const size_t last = s.simplify(2);
+		check(last <= left && s.error() < 1e-4f, "simplifier", "progressive level did not continue");
+
+		const auto result = s.indices();
+		check(result.size() == last * 3, "simplifier", "index count does not match the triangles");
+		const uint32_t vertices = static_cast<uint32_t>(positions.size() / 3);
+		check(std::all_of(result.begin(), result.end(), [&](uint32_t i) { return i < vertices; }),
+			"simplifier", "index out of range");
+
+		// The corners of the grid bound the surface, collapses must keep all four.
+		for (uint32_t corner : { 0u, static_cast<uint32_t>(n), static_cast<uint32_t>(n * (n + 1)), static_cast<uint32_t>(n * (n + 2)) }) {
+			check(std::find(result.begin(), result.end(), corner) != result.end(), "simplifier", "grid corner collapsed");
+		}
+	}
+
+	bool init_gl() {
+		if (!glfwInit()) {
+			return false;
+		}
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* window = glfwCreateWindow(64, 64, "UnitTests", nullptr, nullptr);
+		if (window == nullptr) {
+			return false;
+		}
+		glfwMakeContextCurrent(window);
+		return glewInit() == GLEW_OK;
+	}
+}
+
+int main()
+{
+	test_bvh();
+	test_culling();
+	test_animation();
+	test_frame_store();
+	test_simplifier();
+
+	if (init_gl()) {
+		test_framegraph();
+	}
+	else {
+		std::cerr << "framegraph: no GL context" << std::endl;
+		failures++;
+	}
+	glfwTerminate();
+
+	if (failures > 0) {
+		std::cerr << failures << " checks failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return EXIT_SUCCESS;
+}